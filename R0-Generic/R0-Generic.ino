@@ -266,17 +266,17 @@ int FreezeLastTime = millis() - FreezeInterval;
 #include <OneWire.h>
 const int oneWirePin = D3;  // D3 = I2C-BUS (Check: 4.7K pull-up resistor to Vcc!)
 OneWire ds = OneWire(oneWirePin);
-// Names of sensors are double variables => can be published as "Particle.variables"
+#include <SensorArray.h>
+SensorArray<1, 3> room(addrs0); // Readings of the sensor(s) in addrs0: ROM, reading, error count, time of the last good reading. Median of the last 3 readings: rejects a single spike, 1 interval delay on a real change
+#include <TBus.h>
+TBus tbus(ds, room.rom, room.count); // Non-blocking DS18B20 reader: loop() keeps running during the conversion
+// Names of sensors are doubles => can be published as "Particle.variables" (copied from room.filtered[] in getTemperatures())
 double ROOMTemp1;
-double* temps[] = {&ROOMTemp1};
-// For time stamp (Faulty sensor reporting via CRC checking):
+// Faulty sensor reporting via CRC checking:
 char crcErrorJSON[128];
-int crcErrorCount[sizeof(temps)/sizeof(temps[0])];
-uint32_t tmStamp[sizeof(temps)/sizeof(temps[0])];
+char tbusJSON[160]; // T-BUS health counters (OneWire::statsJSON) => Particle.variable "TBUS_health"
 // For temperature calculations:
 int getTemperaturesInterval = 5 * 60 * 1000; // Sample rate for temperatures (s): To avoid "nervous" frequent heating ON/OFF switching, set this interval high enough! (>2 min)
-int getTemperaturesLastTime = millis() - getTemperaturesInterval;  // Reset heating setting interval to sample immediately at start-up!
-double celsius; // Holds the temperature from the array of sensors "per shot"...
 double Tout = 18; // Initial temperature setting when OUT of home (After measuring Roomtemp2, Tout is set to safe condens limit)
 String outTEMPstatus = "outTEMPstatus?"; // Temporary string
 boolean TdfALERT = 0; // Condens alert ON
@@ -284,9 +284,28 @@ boolean TdfALERT = 0; // Condens alert ON
 // *D4 - PIXEL-line
 #include <neopixel.h>
 #define PIXEL_COUNT 50
-#define PIXEL_PIN D4
+#define PIXEL_PIN D4 // Or A5 (SPI MOSI, instead of MOV2): frames sent by SPI + DMA, without blocking interrupts (neopixel.h)
 #define PIXEL_TYPE WS2812
-Adafruit_NeoPixel strip = Adafruit_NeoPixel(PIXEL_COUNT, PIXEL_PIN, PIXEL_TYPE);
+Adafruit_NeoPixelStatic<PIXEL_COUNT, PIXEL_PIN, PIXEL_TYPE> strip;
+#include <Fader.h>
+Fader fader(strip); // Non-blocking light fades: DimUp(), DimDown()... (Fader.h)
+#include <LightScenes.h>
+// Light groups = which PowerPixels make one light (Attention: First in string = 0!) and the scenes of this room (LightScenes.h)
+enum { grMOV1, grMOV2, grSTORE, grSTAIRS };
+const LightGroup lightGroups[] = {
+  { "MOV1",   LIGHT_PIXEL(0) | LIGHT_PIXEL(2) }, // Spanlampen inkom + Staircase RGB strips
+  { "MOV2",   LIGHT_PIXEL(1) },                  // Second group of lights
+  { "STORE",  LIGHT_PIXEL(3) },                  // SSR of the 230V STORE led power
+  { "STAIRS", LIGHT_PIXEL(2) },                  // Staircase RGB strips only (BedTime)
+};
+LightScenes scenes(strip, lightGroups, sizeof(lightGroups) / sizeof(lightGroups[0]));
+const LightScene MOV1on[]    = { { grMOV1, LIGHT_PICKED }, { LIGHT_END } };           // Colour of the web color picker: ledrgb()
+const LightScene MOV1night[] = { { grSTAIRS, LIGHT_RGB(0,0,100) }, { LIGHT_END } };   // BedTime: Light BLUE on the staircase only
+const LightScene MOV1off[]   = { { grMOV1, LIGHT_OFF }, { LIGHT_END } };
+const LightScene MOV2on[]    = { { grMOV2, LIGHT_PICKED }, { LIGHT_END } };
+const LightScene MOV2off[]   = { { grMOV2, LIGHT_OFF }, { LIGHT_END } };              // Also BedTime: No lights anymore here!
+const LightScene STOREon[]   = { { grSTORE, LIGHT_RGB(255,255,255) }, { LIGHT_END } }; // SIMPLE SWITCH ON = SSR switches 230V led power ON
+const LightScene STOREoff[]  = { { grSTORE, LIGHT_OFF }, { LIGHT_END } };
 int rgb[3]; // To STORE the RGB colour picked from the web page for this controller.
 
 // *D5 - RoomSense MOV1: Entrance & Staircase
@@ -436,22 +455,24 @@ void setup()
   } // endif ROOM setting "OLED"
 
   // *D3 - RoomSense T-BUS
-  for (int i = 0; i < sizeof(temps)/sizeof(temps[0]); i++)
-  {
-    tmStamp[i] = Time.now();
-  }
+  room.begin(Time.now()); // Start the timeout clock(s): no "Sensor Timeout" on a bad first reading
+  tbus.bind(0); // Auto-binding: Sensor ID(s) kept in EEPROM (address 0). Checked with one read per sensor, search only if one is missing.
+  tbus.setPipelined(getTemperaturesInterval); // tbus.poll() reads + starts the next conversion every interval: a reading is ready without waiting (first one at start-up)
   //Particle.variable("CRC_Errors", crcErrorJSON, STRING); // Only needed for debugging: Shows accumulated number of errors...
+  Particle.variable("TBUS_health", tbusJSON, STRING); // Resets, presence failures, bus timeouts, read errors per sensor ID, bytes and µs with interrupts off: spot a degrading cable before a sensor times out
   Particle.variable("ROOM_Temp1", &ROOMTemp1, DOUBLE);
 
   // *D4 - PIXEL-line
   Particle.function("rgb", ledrgb); // Show currently selected colour value from webpage (For debugging only!)
   strip.begin(); strip.show(); // Initialize all pixels to 'off'
+  strip.setDeferred(true); // From here on show() only asks for a frame: loop() sends it (strip.flush()), once per pass
 
   // Initialize RGB color, until "mobile color picker" can be used;
   // ATTENTION: This MUST be in setup() !!!
   rgb[0] = 255; // Red      (0-255)
   rgb[1] = 255; // Green    (0-255)
   rgb[2] = 255;  // Blue     (0-255)
+  scenes.setPicked(strip.Color(rgb[0], rgb[1], rgb[2]));
 
   // *D5 - RoomSense MOV1 (Default)
   pinMode(MOV1pin, INPUT_PULLUP); // IMPORTANT!!! Input forced HIGH.
@@ -476,6 +497,10 @@ void loop()
   if (!strlen(device_name)) // If the variable has not received contents...
       Particle.publish("particle/device/name"); // Ask the cloud (once) to send the device NAME!
 
+  // Light fades: next step of every fade (non-blocking, see Fader.h) + send the pixels changed since the last pass
+  fader.update();
+  strip.flush();
+
   // General commands:
   // 1a. Check memory
   freemem = System.freeMemory();// For debugging: Track if memory leak exists...
@@ -934,9 +959,10 @@ if (strcmp(OP5_A7, "ALERTRCV") == 0)
 
 
 // *D3 - T-BUS: Reports to HVAC controller if there is condens danger. (= Std function)
-if ((millis()-getTemperaturesLastTime)>getTemperaturesInterval) // To avoid "nervous" frequent switching, set this interval high enough!
+if (tbus.poll()) // Every getTemperaturesInterval (pipelined): all scratchpads are read, the next conversion is running. To avoid "nervous" frequent switching, set this interval high enough!
 {
   getTemperatures(0); // Update all sensor variables of array 0 (DS18B20 type)
+  ds.statsJSON(tbusJSON, sizeof(tbusJSON)); // Update "TBUS_health"
   // Actions/calculations with T-BUS output:
   if (ROOMTemp1 < Tout) // Report if room temperature is close to the condensation limit (Tout is a few degrees higher for safety!) Added a max limit for Tout of 16°C...
   {
@@ -949,7 +975,6 @@ if ((millis()-getTemperaturesLastTime)>getTemperaturesInterval) // To avoid "ner
     TdfALERT = 0;
   }
   Particle.publish(stat_HEAT, outTEMPstatus);
-  getTemperaturesLastTime = millis(); // Reset the timer
 }
 
 
@@ -1341,34 +1366,15 @@ void readAlert() // Check if Alert hits LDR or not => STOREAlertLevel => Control
 
 
 // *D3 - RoomSense T-BUS
-// Read the DS18B20 precision room temperature sensor(s)...
+// Process the DS18B20 precision room temperature sensor(s) collected by tbus.poll() (Non-blocking: no more delay(1000) for the conversion)...
 void getTemperatures(int select)
 {
-  ds.reset();
-  ds.skip();
-  ds.write(0x44, 0);
-  delay(1000);
-  ds.reset();
-
-  for (int i=0; i< sizeof(temps)/sizeof(temps[0]); i++)
+  for (int i=0; i< room.count; i++)
   {
-    ds.select(addrs0[i]);
-    ds.write(0xBE,0);
-    byte scratchpadData[9];
-
-    for (int i = 0; i < 9; i++) // we only need 9 bytes
-    {
-      scratchpadData[i] = ds.read();
-    }
-
-    byte currentCRC = (OneWire::crc8(scratchpadData, 8));
-
-    ds.reset();
-
-    if (currentCRC != scratchpadData[8])
+    if (!room.update(i, tbus, Time.now())) // Good reading: stored in room.centi[i] and filtered into room.filtered[i] (1/100 °C)
     {
       String message;
-      if (Time.now() - tmStamp[i] > 3600UL)  // one hour in this example
+      if (room.age(i, Time.now()) > 3600UL)  // one hour in this example
       {
         message = "Sensor Timeout on ROOMsensor: ";
       }
@@ -1377,62 +1383,25 @@ void getTemperatures(int select)
         message = "Bad reading on ROOMsensor: ";
       }
       Particle.publish(stat_HEAT, message + String(i), 60, PRIVATE);
-      crcErrorCount[i]++;
-      delay(1000);
-      continue;
     }
+  }
 
-    tmStamp[i] = Time.now();
-
-    int16_t raw = (scratchpadData[1] << 8) | scratchpadData[0];
-    celsius = (double)raw * 0.0625;
+  ROOMTemp1 = room.celsius(0);
 
-    // construct the CRC error array
-    strcpy(crcErrorJSON, "{\"errorCount\":[");
-    for (int i = 0; i < sizeof(temps)/sizeof(temps[0]); i++)
-    {
-      char buffer[10];
-      itoa(crcErrorCount[i], buffer, 10);
-      strcat(crcErrorJSON, buffer);
-      if(i < sizeof(temps)/sizeof(temps[0]) - 1)
-      strcat(crcErrorJSON, ",");
-    }
-    strcat(crcErrorJSON, "]}");
-    *temps[i] = celsius;
-  }
+  // construct the CRC error array
+  room.updateErrorJSON(crcErrorJSON, sizeof(crcErrorJSON)); // Only rewritten when a count changed
 }
 
 
 
-// *D3 - T-BUS: 1-wire bus Scanner function  => Addresses of 1-wire devices are published to Particle cloud. For example T-BUS (pin D3) DS18B20 sensors
+// *D3 - T-BUS: 1-wire bus Scanner function  => Addresses of 1-wire devices are published to Particle cloud in one JSON event. For example T-BUS (pin D3) DS18B20 sensors
+// A new sensor (ex: replaced RoomSenseBoX) takes over the slot of the missing one and is stored in EEPROM: No reflash needed!
 void discoverOneWireDevices(void)
 {
-  //Temporary: Commented next 3 lines to test if necessary
-  //byte i;
-  //byte present = 0;
-  //byte data[12];
-  byte addr[8];
-  int sensorCount = 0;
-
-  Particle.publish("OneWire", "Looking for 1-wire addresses:", 60, PRIVATE);
-
-  while(ds.search(addr) and sensorCount < 20)
-  {
-    sensorCount++;
-    char newAddress[48] = ""; // Make space for the 48 characters of our sensor addresses.
-    snprintf(newAddress, sizeof(newAddress), "0x%02X,0x%02X,0x%02X,0x%02X,0x%02X,0x%02X,0x%02X,0x%02X", addr[0], addr[1], addr[2], addr[3], addr[4], addr[5], addr[6], addr[7]);
-    Particle.publish("OneWire", newAddress, 60, PRIVATE);
-
-    if ( OneWire::crc8( addr, 7) != addr[7])
-    {
-      Particle.publish(stat_ALERT, "CRC is not valid!", 60, PRIVATE);
-      return;
-    }
-  }
-
-  ds.reset_search();
-  Particle.publish("OneWire", "No more addresses!", 60, PRIVATE);
-  return;
+  char romJSON[128];
+  tbus.scan(); // Full search of the T-BUS
+  tbus.romJSON(romJSON, sizeof(romJSON)); // Example: {"roms":["28FF1A3A33170403"],"new":[],"miss":[]}
+  Particle.publish("OneWire", romJSON, 60, PRIVATE);
 }
 
 
@@ -1467,12 +1436,13 @@ int ledrgb( String value )
   rgb[0] = redgreenblue[0].toInt();
   rgb[1] = redgreenblue[1].toInt();
   rgb[2] = redgreenblue[2].toInt();
+  scenes.setPicked(strip.Color(rgb[0], rgb[1], rgb[2])); // = LIGHT_PICKED in the scenes
 
   // Publish the selected colour:
   sprintf(str, "Colour:%d-%d-%d",rgb[0],rgb[1],rgb[2]);
   Particle.publish(stat_LIGHT, str);
 
-  // Turn on all related RGB lights to confirm the set color:
+  // Turn on all related RGB lights to confirm the set color (deferred show(): both scenes go out in one frame)
   MOV1Lightson();
   MOV2Lightson();
 
@@ -1488,21 +1458,14 @@ void MOV1Lightson() // Turn lights ON.
 {
   if (!BedTime)
   {
-    // Normal lights command
-    // Powerpixel 0 = Spanlampen inkom: Select an option...
-    //strip.setPixelColor(0, strip.Color(255,255,255)); strip.show(); // Simple switching option: R= Spanlampen beneden, B= Spots onder palier (SIMPLE SWITCH ON = For testing)
-    strip.setPixelColor(0, strip.Color(rgb[0], rgb[1], rgb[2])); strip.show(); // Use the web color picker function ledrgb()
+    // Normal lights command: Powerpixel 0 = Spanlampen inkom + Powerpixel 2 = Staircase RGB strips
+    scenes.apply(MOV1on); // Use the web color picker function ledrgb()
     //DimUpGroups(0, 5); // Dimming option: Check "flicker" issues! PowerPiXel 0 = SpanBeneden, Min = 0, Steps = 10 (slow)
-
-    // Powerpixel 2 = Staircase RGB strips: Select an option...
-    //strip.setPixelColor(2, strip.Color(255,255,255)); strip.show(); // Simple switching option (For testing)
-    //DimUpGroupsRG(2, 0, 5); // PowerPiXel 2 = RGB, Min = 0, Steps = 10 (slow)
-    strip.setPixelColor(2, strip.Color(rgb[0], rgb[1], rgb[2])); strip.show(); // Use the web color picker function ledrgb() above!
   }
   else
   {
     // Bedtime! Dimmed lights: Only staircase strip! Powerpixel 2
-    strip.setPixelColor(2, strip.Color(0,0,100)); strip.show(); // Light BLUE Simple switching option (For testing)
+    scenes.apply(MOV1night); // Light BLUE
   }
 
 
@@ -1512,9 +1475,8 @@ void MOV1Lightson() // Turn lights ON.
 
 void MOV1Lightsoff() // Turn lights OFF per colour: R= Spanlampen beneden, G= Spots onder palier
 {
-  // Simple switching option:
-  strip.setPixelColor(0, strip.Color(0,0,0)); // SIMPLE SWITCH OFF = For testing
-  strip.setPixelColor(2, strip.Color(0,0,0)); strip.show(); // RGB lights (SIMPLE SWITCH OFF = For testing)
+  // Simple switching option: Spanlampen + RGB lights OFF in one frame
+  scenes.apply(MOV1off);
 
   // Dimming option: Check "flicker" issues!
   //DimDownGroups(2, 5); // PowerPiXel 2 = RGB, Steps = 10 (slow)
@@ -1528,6 +1490,7 @@ void MOV1Lightsoff() // Turn lights OFF per colour: R= Spanlampen beneden, G= Sp
 void MOV1demo() // One cycle dimming ON/OFF...
 {
   MOV1Lightson();
+  FadeWait(); // Fade-in first (the fades run in loop())
   delay(5000);
   MOV1Lightsoff();
 }
@@ -1543,19 +1506,13 @@ void MOV2Lightson() // Turn second group of lights ON
     {
       // Put here the A7 dimmer commands (BandB)
       // Use MOV2DIMMERpin for PWM output
-      while (DimLightLevel > 0)
-      {
-        DimLightLevel--;
-        analogWrite(A7, DimLightLevel); // Use A7 directly; You cannot create a name for this pin as it may be used for different functions
-        delay(DimStep);
-      }
+      DimA7(0); // Non-blocking: the fade runs in loop(), DimStep ms per level
     } // endif ROOM setting "DIMMER"
 
     else // Variant 2: With Powerpixels
     {
       // Simple switching option:
-      //strip.setPixelColor(1, strip.Color(255,255,255)); strip.show(); // Simple switching: R= Second roomlights (SIMPLE SWITCH ON = For testing)
-      strip.setPixelColor(1, strip.Color(rgb[0], rgb[1], rgb[2])); strip.show(); // Adopt the RGB values set remotely
+      scenes.apply(MOV2on); // Adopt the RGB values set remotely
 
       // Dimming option:
       //DimUp(1, 0, 255, 5); // Spanlampen boven = PowerPiXel 1 (= second), Pixel #, Start - End, Nr of steps
@@ -1569,18 +1526,13 @@ void MOV2Lightson() // Turn second group of lights ON
     {
       // Put here the A7 dimmer commands (BandB)
       // Use MOV2DIMMERpin for PWM output
-      while (DimLightLevel > 0)
-      {
-        DimLightLevel--;
-        analogWrite(A7, DimLightLevel); // Use A7 directly; You cannot create a name for this pin as it may be used for different functions
-        delay(DimStep);
-      }
+      DimA7(0); // Non-blocking: the fade runs in loop(), DimStep ms per level
     } // endif ROOM setting "DIMMER"
 
     else // Variant 2: With Powerpixels
     {
       // Bedtime! No lights anymore here! Powerpixel 1 => Add LEDstrips on wall later...
-      strip.setPixelColor(1, strip.Color(0,0,0)); strip.show(); // Light OFF Simple switching option (For testing)
+      scenes.apply(MOV2off); // Light OFF Simple switching option
     } // endif ROOM setting not "DIMMER"
   }
 
@@ -1595,18 +1547,13 @@ void MOV2Lightsoff() // Turn second group of lights OFF
   {
     // Put here the A7 dimmer commands (BandB)
     // Use MOV2DIMMERpin for PWM output
-    while (DimLightLevel < 255)
-    {
-     DimLightLevel++;
-     analogWrite(A7, DimLightLevel); // Use A7 directly; You cannot create a name for this pin as it may be used for different functions
-     delay(DimStep);
-    }
+    DimA7(255); // Non-blocking: the fade runs in loop(), DimStep ms per level
   } // endif ROOM setting "DIMMER"
 
   else // Variant 2: With Powerpixels
   {
     // Simple switching option:
-    strip.setPixelColor(1, strip.Color(0,0,0)); strip.show(); // R= Second group of lights (SIMPLE SWITCH ON = For testing)
+    scenes.apply(MOV2off); // R= Second group of lights
 
     // Dimming option:
     //DimDown(1, 255, 0, 5); // Spanlampen boven = PowerPiXel 1 (= second), Pixel #, Start - End, Nr of steps
@@ -1620,6 +1567,7 @@ void MOV2Lightsoff() // Turn second group of lights OFF
 void MOV2demo() // One cycle dimming ON/OFF...
 {
   MOV2Lightson();
+  FadeWait(); // Fade-in first (the fades run in loop())
   delay(5000);
   MOV2Lightsoff();
 }
@@ -1630,14 +1578,14 @@ void STORElightsON() // Turn STORE lights ON
 {
   STORElight = 1;
   STORElightOnTime = millis(); // Restart the STORE light ON timer. Will turn OFF lights after expiring...
-  strip.setPixelColor(3, strip.Color(255,255,255)); strip.show(); // PowerPiXel 3 (= fourth) => SIMPLE SWITCH ON = SSR switches 230V led power ON
+  scenes.apply(STOREon); // PowerPiXel 3 (= fourth) => SIMPLE SWITCH ON = SSR switches 230V led power ON
   STORElightstatus = "STORE lights ON"; Particle.publish(stat_LIGHT, STORElightstatus);
 }
 
 void STORElightsOFF() // Turn STORE lights (Powerpixel 3) OFF
 {
   STORElight = 0;
-  strip.setPixelColor(3, strip.Color(0,0,0)); strip.show(); // PowerPiXel 3 (= fourth) => SIMPLE SWITCH ON = SSR switches 230V led power OFF
+  scenes.apply(STOREoff); // PowerPiXel 3 (= fourth) => SIMPLE SWITCH ON = SSR switches 230V led power OFF
   STORElightstatus = "STORE lights OFF"; Particle.publish(stat_LIGHT, STORElightstatus);
 }
 // STOP Specific ROOM settings 2 (for LIGHTING): "Room-INKOM"////////////////////////////////////////////////////////////
@@ -1645,74 +1593,59 @@ void STORElightsOFF() // Turn STORE lights (Powerpixel 3) OFF
 
 
 
-// BASIC POWERPIXEL CONTROL FUNCTIONS:
-// 1. Increases brightness of all groups of a PowerPixel in steps. Parameters: Pixel #, Start - End, Nr of steps (1 = fast, more = slower) ex: DimUp(0, 0, 255, 5);
+// A7 PWM dimmer (BandB): fades to 'to' from its present level, also when it is still fading, DimStep ms per level
+void DimA7(uint8_t to)
+{
+  uint8_t from = fader.level(A7, FADER_PWM, DimLightLevel); // DimLightLevel = target of the last fade: only used if the fader does not know A7
+  fader.fadePWM(A7, from, to, (uint32_t)abs(to - from) * DimStep); // Use A7 directly; You cannot create a name for this pin as it may be used for different functions
+  DimLightLevel = to;
+}
+
+// BASIC POWERPIXEL CONTROL FUNCTIONS: Non-blocking! They only start a fade, loop() runs it (fader.update(), see Fader.h).
+// Same speed as the old delay() loops: 'wait' ms per level.
+// 1. Increases brightness of all groups of a PowerPixel. Parameters: Pixel #, Start - End, ms per step (1 = fast, more = slower) ex: DimUp(0, 0, 255, 5);
 void DimUp(uint8_t Nr, uint8_t min, uint8_t max, uint8_t wait)
 {
-  for(int i=min;i<max;i++)
-  {
-    strip.setPixelColor(Nr, strip.Color(i,i,i));
-    strip.show();
-    delay(wait);
-  }
+  if (fader.busy(Nr)) min = fader.level(Nr, FADER_RED); // Still fading: go on from where it is now, the time counted from there
+  fader.fade(Nr, strip.Color(min,min,min), strip.Color(max,max,max), (uint32_t)abs(max - min) * wait);
 }
 
-// 2. Decreases brightness of all groups of a PowerPixel in steps: Parameters: Pixel #, Start - End, Nr of steps (1 = fast, more = slower) ex: DimDown(0, 255, 0, 5);
+// 2. Decreases brightness of all groups of a PowerPixel: Parameters: Pixel #, Start - End, ms per step (1 = fast, more = slower) ex: DimDown(0, 255, 0, 5);
 void DimDown(uint8_t Nr, uint8_t max, uint8_t min, uint8_t wait)
 {
-  for(int i=max;i>=min;i--)
-  {
-    strip.setPixelColor(Nr, strip.Color(i,i,i));
-    strip.show();
-    delay(wait);
-  }
+  if (fader.busy(Nr)) max = fader.level(Nr, FADER_RED); // Still fading: go on from where it is now, the time counted from there
+  fader.fade(Nr, strip.Color(max,max,max), strip.Color(min,min,min), (uint32_t)abs(max - min) * wait);
 }
 
-// 3. Fades each group of a PowerPixel OFF in turn: Parameters: Pixel #, Minimum, Nr of steps (1 = fast, more = slower) ex: DimDownGroups(0, 5);
+// 3. Fades each group of a PowerPixel OFF in turn (R, then G, then B): Parameters: Pixel #, ms per step (1 = fast, more = slower) ex: DimDownGroups(0, 5);
 void DimDownGroups(uint8_t Nr, uint8_t wait)
 {
-  for(int i=255;i>=0;i--)
-  {
-    strip.setPixelColor(Nr, strip.Color(i,255,255));
-    strip.show();
-    delay(wait);
-  }
-  for(int i=255;i>=0;i--)
-  {
-    strip.setPixelColor(Nr, strip.Color(0,i,255));
-    strip.show();
-    delay(wait);
-  }
-  for(int i=255;i>=0;i--)
-  {
-    strip.setPixelColor(Nr, strip.Color(0,0,i));
-    strip.show();
-    delay(wait);
-  }
+  uint32_t t = 255 * (uint32_t)wait; // Fade time of one group
+
+  fader.fadeChannel(Nr, FADER_RED, 255, 0, t);
+  fader.fadeChannel(Nr, FADER_GREEN, 255, 0, t, t); // Starts when R is OFF
+  fader.fadeChannel(Nr, FADER_BLUE, 255, 0, t, 2 * t);
 }
 
-// 4. Fades each group of a PowerPixel ON in turn: Parameters: Pixel #, Minimum, Nr of steps (1 = fast, more = slower) ex: DimUpGroups(0, 5);
+// 4. Fades each group of a PowerPixel ON in turn (R, then G, then B): Parameters: Pixel #, ms per step (1 = fast, more = slower) ex: DimUpGroups(0, 5);
 void DimUpGroups(uint8_t Nr, uint8_t wait)
 {
-  for(int i=0;i<255;i++)
-  {
-    strip.setPixelColor(Nr, strip.Color(i,0,0));
-    strip.show();
-    delay(wait);
-  }
+  uint32_t t = 255 * (uint32_t)wait; // Fade time of one group
+
+  fader.fadeChannel(Nr, FADER_RED, 0, 255, t);
+  fader.fadeChannel(Nr, FADER_GREEN, 0, 255, t, t); // Starts when R is ON
+  fader.fadeChannel(Nr, FADER_BLUE, 0, 255, t, 2 * t);
+}
 
-  for(int i=0;i<255;i++)
+// 5. Runs the fades to their end. Demo only: blocks loop() like the old delay() loops did.
+void FadeWait()
+{
+  while (fader.update())
   {
-    strip.setPixelColor(Nr, strip.Color(255,i,0));
-    strip.show();
-    delay(wait);
+    strip.flush();
+    delay(10);
   }
-  for(int i=0;i<255;i++)
-  {
-    strip.setPixelColor(Nr, strip.Color(255,255,i));
-    strip.show();
-    delay(wait);
-    }
+  strip.flush();
 }
 
 
@@ -107,16 +107,18 @@ int getTstatLastTime = millis() - getTstatInterval;  // Reset Tstat reading inte
 #include <OneWire.h>
 const int oneWirePin = D3;  // D3 = I2C-BUS (Check: 4.7K pull-up resistor to Vcc!)
 OneWire ds = OneWire(oneWirePin);
+#include <TBus.h>
+TBus tbus(ds, addrs0, sizeof(addrs0)/sizeof(addrs0[0])); // Non-blocking DS18B20 reader: loop() keeps running during the conversion
 // Names of sensors are double variables => can be published as "Particle.variables"
 double ROOMTemp1;
 double* temps[] = {&ROOMTemp1};
 // For time stamp (Faulty sensor reporting via CRC checking):
 char crcErrorJSON[128];
+char tbusJSON[160]; // T-BUS health counters (OneWire::statsJSON) => Particle.variable "TBUS_health"
 int crcErrorCount[sizeof(temps)/sizeof(temps[0])];
 uint32_t tmStamp[sizeof(temps)/sizeof(temps[0])];
 // For temperature calculations:
 int getTemperaturesInterval = 5 * 60 * 1000; // Sample rate for temperatures (s): To avoid "nervous" frequent heating ON/OFF switching, set this interval high enough! (>2 min)
-int getTemperaturesLastTime = millis() - getTemperaturesInterval;  // Reset heating setting interval to sample immediately at start-up!
 double celsius; // Holds the temperature from the array of sensors "per shot"...
 double Tout = 18; // Initial temperature setting when OUT of home (After measuring Roomtemp2, Tout is set to safe condens limit)
 String outTEMPstatus = "outTEMPstatus?"; // Temporary string
@@ -127,7 +129,9 @@ boolean TdfALERT = 0; // Condens alert ON
 #define PIXEL_COUNT 50
 #define PIXEL_PIN D4
 #define PIXEL_TYPE WS2812
-Adafruit_NeoPixel strip = Adafruit_NeoPixel(PIXEL_COUNT, PIXEL_PIN, PIXEL_TYPE);
+Adafruit_NeoPixelStatic<PIXEL_COUNT, PIXEL_PIN, PIXEL_TYPE> strip;
+#include <Fader.h>
+Fader fader(strip); // Non-blocking light fades: DimUp(), DimDown()... (Fader.h)
 int rgb[3]; // To STORE the RGB colour picked from the web page for this controller.
 
 // *D5 - RoomSense MOV1: Entrance & Staircase
@@ -203,13 +207,17 @@ void setup()
   {
     tmStamp[i] = Time.now();
   }
+  tbus.bind(0); // Auto-binding: Sensor ID(s) kept in EEPROM (address 0). Checked with one read per sensor, search only if one is missing.
+  tbus.setPipelined(getTemperaturesInterval); // tbus.poll() reads + starts the next conversion every interval: a reading is ready without waiting (first one at start-up)
 
   //Particle.variable("CRC_Errors", crcErrorJSON, STRING); // Only needed for debugging: Shows accumulated number of errors...
+  Particle.variable("TBUS_health", tbusJSON, STRING); // Resets, presence failures, bus timeouts, read errors per sensor ID, bytes and µs with interrupts off: spot a degrading cable before a sensor times out
   Particle.variable("ROOM_Temp1", &ROOMTemp1, DOUBLE);
 
   // *D4 - PIXEL-line
   Particle.function("rgb", ledrgb); // Show currently selected colour value from webpage (For debugging only!)
   strip.begin(); strip.show(); // Initialize all pixels to 'off'
+  strip.setDeferred(true); // From here on show() only asks for a frame: loop() sends it (strip.flush()), once per pass
 
   // Initialize RGB color, until "mobile color picker" can be used;
   // ATTENTION: This MUST be in setup() !!!
@@ -239,6 +247,10 @@ void loop()
   if (!strlen(device_name)) // If the variable has received contents...
   Particle.publish("particle/device/name"); // Ask the cloud (once) to send the device NAME!
 
+  // Light fades: next step of every fade (non-blocking, see Fader.h) + send the pixels changed since the last pass
+  fader.update();
+  strip.flush();
+
   // General commands:
   // 1. Check memory
   freemem = System.freeMemory();// For debugging: Track if memory leak exists...
@@ -422,9 +434,10 @@ if ((millis()-getTstatLastTime)>getTstatInterval) // This interval can be more f
 }
 
 // *D3 - T-BUS: Reports to HVAC controller if there is condens danger. (= Std function)
-if ((millis()-getTemperaturesLastTime)>getTemperaturesInterval) // To avoid "nervous" frequent switching, set this interval high enough!
+if (tbus.poll()) // Every getTemperaturesInterval (pipelined): all scratchpads are read, the next conversion is running. To avoid "nervous" frequent switching, set this interval high enough!
 {
   getTemperatures(0); // Update all sensor variables of array 0 (DS18B20 type)
+  ds.statsJSON(tbusJSON, sizeof(tbusJSON)); // Update "TBUS_health"
   // Actions/calculations with T-BUS output:
   if (ROOMTemp1 < Tout) // Report if room temperature is close to the condensation limit (Tout is a few degrees higher for safety!) Added a max limit for Tout of 16°C...
   {
@@ -437,7 +450,6 @@ if ((millis()-getTemperaturesLastTime)>getTemperaturesInterval) // To avoid "ner
     TdfALERT = 0;
   }
   Particle.publish(stat_HEAT, outTEMPstatus, 60,PRIVATE);
-  getTemperaturesLastTime = millis(); // Reset the timer
 }
 
 // *D5 - RoomSense MOV1 (= Std function)
@@ -578,31 +590,12 @@ void checkCO2levelPWM(pin_t pulsePin)
 }
 
 // *D3 - RoomSense T-BUS
-// Read the DS18B20 precision room temperature sensor(s)...
+// Process the DS18B20 precision room temperature sensor(s) collected by tbus.poll() (Non-blocking: no more delay(1000) for the conversion)...
 void getTemperatures(int select)
 {
-  ds.reset();
-  ds.skip();
-  ds.write(0x44, 0);
-  delay(1000);
-  ds.reset();
-
-  for (int i=0; i< sizeof(temps)/sizeof(temps[0]); i++)
+  for (int i=0; i< tbus.count(); i++)
   {
-    ds.select(addrs0[i]);
-    ds.write(0xBE,0);
-    byte scratchpadData[9];
-
-    for (int i = 0; i < 9; i++) // we only need 9 bytes
-    {
-      scratchpadData[i] = ds.read();
-    }
-
-    byte currentCRC = (OneWire::crc8(scratchpadData, 8));
-
-    ds.reset();
-
-    if (currentCRC != scratchpadData[8])
+    if (!tbus.valid(i))
     {
       String message;
       if (Time.now() - tmStamp[i] > 3600UL)  // one hour in this example
@@ -615,14 +608,12 @@ void getTemperatures(int select)
       }
       Particle.publish(stat_HEAT, message + String(i), 60, PRIVATE);
       crcErrorCount[i]++;
-      delay(1000);
       continue;
     }
 
     tmStamp[i] = Time.now();
 
-    int16_t raw = (scratchpadData[1] << 8) | scratchpadData[0];
-    celsius = (double)raw * 0.0625;
+    celsius = tbus.celsius(i);
 
     // construct the CRC error array
     strcpy(crcErrorJSON, "{\"errorCount\":[");
@@ -639,34 +630,14 @@ void getTemperatures(int select)
   }
 }
 
-// *D3 - T-BUS: 1-wire bus Scanner function  => Addresses of 1-wire devices are published to Particle cloud. For example T-BUS (pin D3) DS18B20 sensors
+// *D3 - T-BUS: 1-wire bus Scanner function  => Addresses of 1-wire devices are published to Particle cloud in one JSON event. For example T-BUS (pin D3) DS18B20 sensors
+// A new sensor (ex: replaced RoomSenseBoX) takes over the slot of the missing one and is stored in EEPROM: No reflash needed!
 void discoverOneWireDevices(void)
 {
-  //Temporary: Commented next 3 lines to test if necessary
-  //byte i;
-  //byte present = 0;
-  //byte data[12];
-  byte addr[8];
-  int sensorCount = 0;
-
-  Particle.publish("OneWire", "Looking for 1-wire addresses:", 60, PRIVATE); delay(500);
-
-  while(ds.search(addr) and sensorCount < 20)
-  {
-    sensorCount++;
-    char newAddress[48] = ""; // Make space for the 48 characters of our sensor addresses.
-    snprintf(newAddress, sizeof(newAddress), "0x%02X,0x%02X,0x%02X,0x%02X,0x%02X,0x%02X,0x%02X,0x%02X", addr[0], addr[1], addr[2], addr[3], addr[4], addr[5], addr[6], addr[7]); Particle.publish("OneWire", newAddress, 60, PRIVATE); delay(500);
-
-    if ( OneWire::crc8( addr, 7) != addr[7])
-    {
-      Particle.publish(stat_ALERT, "CRC is not valid!", 60, PRIVATE); delay(500);
-      return;
-    }
-  }
-
-  ds.reset_search();
-  Particle.publish("OneWire", "No more addresses!", 60, PRIVATE); delay(500);
-  return;
+  char romJSON[128];
+  tbus.scan(); // Full search of the T-BUS
+  tbus.romJSON(romJSON, sizeof(romJSON)); // Example: {"roms":["28FF1A3A33170403"],"new":[],"miss":[]}
+  Particle.publish("OneWire", romJSON, 60, PRIVATE);
 }
 
 // *D4 - PIXEL-line - PARTICLE FUNCTION
@@ -745,6 +716,7 @@ void MOV1Lightsoff() // Turn lights OFF
 void MOV1demo() // One cycle dimming ON/OFF...
 {
   MOV1Lightson();
+  FadeWait(); // Fade-in first (the fades run in loop())
   delay(5000);
   MOV1Lightsoff();
 }
@@ -773,6 +745,7 @@ void MOV2Lightsoff() // Turn second group of lights OFF
 void MOV2demo() // One cycle dimming ON/OFF...
 {
   MOV2Lightson();
+  FadeWait(); // Fade-in first (the fades run in loop())
   delay(5000);
   MOV2Lightsoff();
 }
@@ -780,74 +753,51 @@ void MOV2demo() // One cycle dimming ON/OFF...
 
 
 
-// BASIC POWERPIXEL CONTROL FUNCTIONS:
-// 1. Increases brightness of all groups of a PowerPixel in steps. Parameters: Pixel #, Start - End, Nr of steps (1 = fast, more = slower) ex: DimUp(0, 0, 255, 5);
+// BASIC POWERPIXEL CONTROL FUNCTIONS: Non-blocking! They only start a fade, loop() runs it (fader.update(), see Fader.h).
+// Same speed as the old delay() loops: 'wait' ms per level.
+// 1. Increases brightness of all groups of a PowerPixel. Parameters: Pixel #, Start - End, ms per step (1 = fast, more = slower) ex: DimUp(0, 0, 255, 5);
 void DimUp(uint8_t Nr, uint8_t min, uint8_t max, uint8_t wait)
 {
-  for(int i=min;i<max;i++)
-  {
-    strip.setPixelColor(Nr, strip.Color(i,i,i));
-    strip.show();
-    delay(wait);
-  }
+  if (fader.busy(Nr)) min = fader.level(Nr, FADER_RED); // Still fading: go on from where it is now, the time counted from there
+  fader.fade(Nr, strip.Color(min,min,min), strip.Color(max,max,max), (uint32_t)abs(max - min) * wait);
 }
 
-// 2. Decreases brightness of all groups of a PowerPixel in steps: Parameters: Pixel #, Start - End, Nr of steps (1 = fast, more = slower) ex: DimDown(0, 255, 0, 5);
+// 2. Decreases brightness of all groups of a PowerPixel: Parameters: Pixel #, Start - End, ms per step (1 = fast, more = slower) ex: DimDown(0, 255, 0, 5);
 void DimDown(uint8_t Nr, uint8_t max, uint8_t min, uint8_t wait)
 {
-  for(int i=max;i>=min;i--)
-  {
-    strip.setPixelColor(Nr, strip.Color(i,i,i));
-    strip.show();
-    delay(wait);
-  }
+  if (fader.busy(Nr)) max = fader.level(Nr, FADER_RED); // Still fading: go on from where it is now, the time counted from there
+  fader.fade(Nr, strip.Color(max,max,max), strip.Color(min,min,min), (uint32_t)abs(max - min) * wait);
 }
 
-// 3. Fades each group of a PowerPixel OFF in turn: Parameters: Pixel #, Nr of steps (1 = fast, more = slower) ex: DimDownGroups(0, 5);
+// 3. Fades each group of a PowerPixel OFF in turn (R, then G, then B): Parameters: Pixel #, ms per step (1 = fast, more = slower) ex: DimDownGroups(0, 5);
 void DimDownGroups(uint8_t Nr, uint8_t wait)
 {
-  for(int i=255;i>=0;i--)
-  {
-    strip.setPixelColor(Nr, strip.Color(i,255,255));
-    strip.show();
-    delay(wait);
-  }
-  for(int i=255;i>=0;i--)
-  {
-    strip.setPixelColor(Nr, strip.Color(0,i,255));
-    strip.show();
-    delay(wait);
-  }
-  for(int i=255;i>=0;i--)
-  {
-    strip.setPixelColor(Nr, strip.Color(0,0,i));
-    strip.show();
-    delay(wait);
-  }
+  uint32_t t = 255 * (uint32_t)wait; // Fade time of one group
+
+  fader.fadeChannel(Nr, FADER_RED, 255, 0, t);
+  fader.fadeChannel(Nr, FADER_GREEN, 255, 0, t, t); // Starts when R is OFF
+  fader.fadeChannel(Nr, FADER_BLUE, 255, 0, t, 2 * t);
 }
 
-// 4. Fades each group of a PowerPixel ON in turn: Parameters: Pixel #, Nr of steps (1 = fast, more = slower) ex: DimUpGroups(0, 5);
+// 4. Fades each group of a PowerPixel ON in turn (R, then G, then B): Parameters: Pixel #, ms per step (1 = fast, more = slower) ex: DimUpGroups(0, 5);
 void DimUpGroups(uint8_t Nr, uint8_t wait)
 {
-  for(int i=0;i<255;i++)
-  {
-    strip.setPixelColor(Nr, strip.Color(i,0,0));
-    strip.show();
-    delay(wait);
-  }
+  uint32_t t = 255 * (uint32_t)wait; // Fade time of one group
 
-  for(int i=0;i<255;i++)
-  {
-    strip.setPixelColor(Nr, strip.Color(255,i,0));
-    strip.show();
-    delay(wait);
-  }
-  for(int i=0;i<255;i++)
+  fader.fadeChannel(Nr, FADER_RED, 0, 255, t);
+  fader.fadeChannel(Nr, FADER_GREEN, 0, 255, t, t); // Starts when R is ON
+  fader.fadeChannel(Nr, FADER_BLUE, 0, 255, t, 2 * t);
+}
+
+// 5. Runs the fades to their end. Demo only: blocks loop() like the old delay() loops did.
+void FadeWait()
+{
+  while (fader.update())
   {
-    strip.setPixelColor(Nr, strip.Color(255,255,i));
-    strip.show();
-    delay(wait);
+    strip.flush();
+    delay(10);
   }
+  strip.flush();
 }
 
 // *D6 - RoomSense TEMP/HUM
@@ -18,7 +18,7 @@
  #define PIXEL_COUNT 12
  #define PIXEL_PIN D4
  #define PIXEL_TYPE WS2812
- Adafruit_NeoPixel strip = Adafruit_NeoPixel(PIXEL_COUNT, PIXEL_PIN, PIXEL_TYPE);
+ Adafruit_NeoPixelStatic<PIXEL_COUNT, PIXEL_PIN, PIXEL_TYPE> strip;
 
  // Store time related elements for the clock:
  double Hour, Minute, Second;
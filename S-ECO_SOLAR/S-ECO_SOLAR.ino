@@ -94,24 +94,28 @@ OneWire ds = OneWire(oneWirePin);
 
 // Store addresses of DS18B20 sensors (Starting with 0x28,) and activate "getTemperatures(0);" in loop() function:
 byte addrs0[6][8] = {{0x28,0xFF,0x0D,0x4C,0x05,0x16,0x03,0xC7}, {0x28,0xFF,0x25,0x1A,0x01,0x16,0x04,0xCD}, {0x28,0xFF,0x89,0x19,0x01,0x16,0x04,0x57}, {0x28,0xFF,0x21,0x9F,0x61,0x15,0x03,0xF9}, {0x28,0xFF,0x16,0x6B,0x00,0x16,0x03,0x08}, {0x28,0xFF,0x90,0xA2,0x00,0x16,0x04,0x76}}; // = For 6 "DS18B20" sensors in ECO buffer
+byte resolution0[6] = {10,10,10,10,10,10}; // Resolution (9..12 bit) per sensor in addrs0: 10 bit = 0.25°C in 188 ms (12 bit = 0.0625°C in 750 ms)
 
-// Initialize the names of the sensors as double variables: (=> can be published as "Particle.variables")
-double ETopH, ETopL, EMidH, EMidL, EBotH, EBotL; // = 6 sensors (012345) in the ECO boiler
-double* temps[] = {&ETopH, &ETopL, &EMidH, &EMidL, &EBotH, &EBotL}; // Group1: 6 sensors (012345) in the ECO boiler
+// Metingen van de 6 sensoren in addrs0: ROM, meting, foutteller en tijd van de laatste goede meting, elk in één array (verkeerd aantal ROMs in addrs0 => compileert niet)
+#include <SensorArray.h>
+SensorArray<6> eco(addrs0); // = 6 sensors (012345) in the ECO boiler
+// Names of the sensors: references into eco.filtered[] (1/100 °C, zie FixedPoint.h): mediaan van de laatste 5 metingen, één foute meting haalt EQtot/dEQ en de pompbeslissingen niet
+centi_t &ETopH = eco.filtered[0], &ETopL = eco.filtered[1], &EMidH = eco.filtered[2], &EMidL = eco.filtered[3], &EBotH = eco.filtered[4], &EBotL = eco.filtered[5];
+#include <TBus.h>
+TBus tbus(ds, eco.rom, eco.count); // Non-blocking reader: loop() blijft lopen tijdens de conversie
 
-// Initialize the globals for time stamp (Faulty sensor reporting via CRC checking):
+// Faulty sensor reporting via CRC checking:
 char crcErrorJSON[128];
-int crcErrorCount[sizeof(temps)/sizeof(temps[0])];
-uint32_t tmStamp[sizeof(temps)/sizeof(temps[0])];
+char tbusJSON[256]; // T-BUS gezondheidstellers (OneWire::statsJSON) => Particle.variable "TBUS_health"
 
 // Global variables for energy calculations:
 int getTemperaturesInterval = 1 * 60 * 1000; // Sample rate for temperatures
-int getTemperaturesLastTime = millis() - getTemperaturesInterval;  // Reset so that it samples immediately at start-up!
-double celsius;
-double ETmin = 35; // Minimum ECO boiler temperature to calculate "spare" energy (Securing Hot water supply)
-double EAv1, EAv2, EAv3, EAv4, EAv5, EAv; // Average temperatures
-double EQ1, EQ2, EQ3, EQ4, EQ5, EQtot, prev_EQtot, dEQ; // Boiler energy
+// Energieberekeningen in vaste komma (geen FPU op de Photon): temperaturen in 1/100 °C, energie in Wh (= 1/1000 kWh). Alleen de JSON en publish rekenen om naar kWh / °C
+centi_t ETmin = CENTI(35); // Minimum ECO boiler temperature to calculate "spare" energy (Securing Hot water supply)
+centi_t EAv1, EAv2, EAv3, EAv4, EAv5, EAv; // Average temperatures (1/100 °C)
+mkwh_t EQ1, EQ2, EQ3, EQ4, EQ5, EQtot, prev_EQtot, dEQ; // Boiler energy (Wh)
 const unsigned long DEQ_INTERVAL = 10 * 60 * 1000; // Elke 10' een dEQ voor JSON STRING
+const mkwh_t EQ_EVACUATE = MKWH(15); // Boven 15 kWh: overschot naar de SCH boiler van HVAC (Status-HEAT:HVAC)
 static unsigned long lastDEQcalc = 0;
 
 // Define variables for SOLAR controller: *A7: PWM, *D2: relay
@@ -163,10 +167,11 @@ void setup()
   Time.zone(+2); // Set clock to Belgium time (+1 in winter, +2 in summer)
 
   // *D3 - T-BUS
-  for (int i = 0; i < sizeof(temps)/sizeof(temps[0]); i++) // @BulldogLowell: Initialize the timestamp array: prevent wrong messages if you get a bad CRC error on the first reading after startup...
-  {
-    tmStamp[i] = Time.now();
-  }
+  eco.begin(Time.now()); // @BulldogLowell: Initialize the timestamps: prevent wrong messages if you get a bad CRC error on the first reading after startup...
+  eco.setLimits(CENTI(1), CENTI(99)); // Plausibele boilertemperaturen: al de rest is een foute meting
+  tbus.bind(0); // Auto-binding: sensor IDs in EEPROM (adres 0). Eén read per sensor, search enkel als er een ontbreekt. addrs0 dient bij de eerste start en na elke wijziging ervan.
+  tbus.setResolution(resolution0); // Resolutie per sensor instellen: kortere conversietijd
+  tbus.setPipelined(getTemperaturesInterval); // tbus.poll() leest + start meteen de volgende conversie, elke interval: geen wachttijd voor ECOtransfer()
 
   // Initialize pin mode for SOLAR controller
   pinMode(relayPin, OUTPUT);
@@ -190,6 +195,7 @@ void setup()
 
   // Report the CRC errors with sensor ID:
   Particle.variable("CRC_Errors", crcErrorJSON, STRING); // It creates an array of errorcounts of all active sensors. Example: {"errorCount":[17,4,4,14,8,3]} => 17 = sensor 0, 4 = sensor 1, etc...
+  Particle.variable("TBUS_health", tbusJSON, STRING); // Resets, geen presence, bus timeouts, leesfouten per sensor ID, bytes en µs met interrupts uit: een slechte kabel zien voordat een sensor uitvalt
 }
 
 
@@ -218,24 +224,24 @@ void loop()
   }
 
   // === TEMPERATUREN & ENERGIE (elke minuut) ===
-  if ((millis() - getTemperaturesLastTime) > getTemperaturesInterval)
+  if (tbus.poll()) // Elke getTemperaturesInterval (pipelined): alle scratchpads gelezen, de volgende conversie loopt al
   {
     getTemperatures(0);
-    getTemperaturesLastTime = millis();
+    ds.statsJSON(tbusJSON, sizeof(tbusJSON)); // Update "TBUS_health"
 
     // --- ENERGIEBEREKENINGEN ---
-    EAv1 = (ETopH + ETopL)/2;
-    EAv2 = (ETopL + EMidH)/2;
-    EAv3 = (EMidH + EMidL)/2;
-    EAv4 = (EMidL + EBotH)/2;
-    EAv5 = (EBotH + EBotL)/2;
-    EAv = (EAv1+EAv2+EAv3+EAv4+EAv5)/5;
-
-    EQ1 = (EAv1-ETmin)*110*1.163/1000;
-    EQ2 = (EAv2-ETmin)*90*1.163/1000;
-    EQ3 = (EAv3-ETmin)*90*1.163/1000;
-    EQ4 = (EAv4-ETmin)*90*1.163/1000;
-    EQ5 = (EAv5-ETmin)*110*1.163/1000;
+    EAv1 = centiAverage(ETopH, ETopL);
+    EAv2 = centiAverage(ETopL, EMidH);
+    EAv3 = centiAverage(EMidH, EMidL);
+    EAv4 = centiAverage(EMidL, EBotH);
+    EAv5 = centiAverage(EBotH, EBotL);
+    EAv = ((int32_t)EAv1+EAv2+EAv3+EAv4+EAv5)/5;
+
+    EQ1 = zoneEnergy(EAv1, ETmin, 110);
+    EQ2 = zoneEnergy(EAv2, ETmin, 90);
+    EQ3 = zoneEnergy(EAv3, ETmin, 90);
+    EQ4 = zoneEnergy(EAv4, ETmin, 90);
+    EQ5 = zoneEnergy(EAv5, ETmin, 110);
     EQtot = EQ1+EQ2+EQ3+EQ4+EQ5;
 
     if (millis() - lastDEQcalc >= DEQ_INTERVAL)
@@ -247,7 +253,7 @@ void loop()
 
 
     Tsun = readSolarTemp();
-    Tboil = EBotH;
+    Tboil = centiToDouble(EBotH);
     dT = Tsun - Tboil;
 
 
@@ -261,16 +267,16 @@ void loop()
      "\"Solar\":%.1f,\"dT\":%.1f,\"dEQ\":%.3f,\"pwmVal\":%.0f,"
       "\"Relay\":%.0f,\"WiFiSig\":%d,\"Mem\":%d"
     "}",
-      ETopH, ETopL, EMidH, EMidL, EBotH, EBotL, EAv, EQtot,
-      Tsun, dT, dEQ, pwmValue, relay,
+      centiToDouble(ETopH), centiToDouble(ETopL), centiToDouble(EMidH), centiToDouble(EMidL), centiToDouble(EBotH), centiToDouble(EBotL), centiToDouble(EAv), mkWhToDouble(EQtot),
+      Tsun, dT, mkWhToDouble(dEQ), pwmValue, relay,
       wifiRSSI, memPERCENT
     );
 
     // --- EVACUATE (HVAC) ---
     static unsigned long lastEvacuate = 0;
-    if (EQtot > 15 && millis() - lastEvacuate >= 300000)
+    if (EQtot > EQ_EVACUATE && millis() - lastEvacuate >= 300000)
     {
-      sprintf(str, "ECO: %.2f kWh", EQtot);
+      sprintf(str, "ECO: %.2f kWh", mkWhToDouble(EQtot));
       if (Particle.connected())
       {
         Particle.publish("Status-HEAT:HVAC", str, PRIVATE);
@@ -336,7 +342,7 @@ void solarPump() {
   }
 
   // 4. Verlies-streak – 100 % IDENTIEK AAN GOOGLE SHEETS
-  if (dEQ <= 0.0) {
+  if (dEQ <= 0) {
     consecutiveReductions++;
     if (consecutiveReductions >= 3) {
       shouldBeOn = false;
@@ -391,102 +397,39 @@ void solarPump() {
 
 
 // *D3 - T-BUS
-void discoverOneWireDevices(void) // T-BUS Scanner function  => List addresses of all 1-wire devices on the T-BUS (D3) and publish to Particle cloud. For example T-BUS DS18B20 sensors => discoverOneWireDevices();
+void discoverOneWireDevices(void) // T-BUS Scanner function  => List addresses of all 1-wire devices on the T-BUS (D3) and publish to Particle cloud in one JSON event. For example T-BUS DS18B20 sensors => discoverOneWireDevices();
 {
-  byte i;
-  byte present = 0;
-  byte data[12];
-  byte addr[8];
-  int sensorCount = 0;
-
-  Particle.publish("OneWire", "Looking for 1-wire addresses:", 60, PRIVATE); delay(500);
-
-  while(ds.search(addr) and sensorCount < 20)
-  {
-    sensorCount++;
-    char newAddress[48] = ""; // Make space for the 48 characters of our sensor addresses.
-    snprintf(newAddress, sizeof(newAddress), "0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X", addr[0], addr[1], addr[2], addr[3], addr[4], addr[5], addr[6], addr[7]);
-    Particle.publish("OneWire", newAddress, 60, PRIVATE); delay(500);
-
-    if ( OneWire::crc8( addr, 7) != addr[7])
-    {
-      Particle.publish("OneWire", "CRC is not valid!", 60, PRIVATE); delay(500);
-      return;
-    }
-  }
-
-  ds.reset_search();
-  Particle.publish("OneWire", "No more addresses!", 60, PRIVATE); delay(500);
-  return;
+  // Een nieuwe sensor neemt de plaats in van een ontbrekende en wordt bewaard in EEPROM: geen reflash nodig!
+  char romJSON[200];
+  tbus.scan(); // Volledige search van de T-BUS
+  tbus.romJSON(romJSON, sizeof(romJSON)); // Voorbeeld: {"roms":["28FF0D4C051603C7",...],"new":[],"miss":[]}
+  Particle.publish("OneWire", romJSON, 60, PRIVATE);
 }
 
 
 
 
 // T-BUS collecting temperatures function => Reviewed by Grok!
+// Conversie en lezen gebeurt door tbus (zonder delay), hier worden enkel de resultaten verwerkt.
 void getTemperatures(int select)
 {
-  static unsigned long conversionStart = 0;
-  static bool conversionRequested = false;
-
-  // Stap 1: Start conversie (alleen 1x per interval)
-  if (!conversionRequested && (millis() - getTemperaturesLastTime > getTemperaturesInterval)) {
-    ds.reset();
-    ds.skip();
-    ds.write(0x44, 0);  // Start temperatuurconversie
-    conversionStart = millis();
-    conversionRequested = true;
-    return;
-  }
-
-  // Stap 2: Wacht 1 sec, dan lezen
-  if (conversionRequested && (millis() - conversionStart >= 1000)) {
-    ds.reset();
-    conversionRequested = false;
-    getTemperaturesLastTime = millis();
-
-    for (int i = 0; i < sizeof(temps)/sizeof(temps[0]); i++) {
-      ds.select(addrs0[i]);
-      ds.write(0xBE, 0);
-      byte scratchpadData[9];
-      for (int j = 0; j < 9; j++) {
-        scratchpadData[j] = ds.read();
-      }
-      byte currentCRC = OneWire::crc8(scratchpadData, 8);
-      ds.reset();
-
-      if (currentCRC != scratchpadData[8]) {
-        char msg[64];
-        if (Time.now() - tmStamp[i] > 3600UL) {
-          snprintf(msg, sizeof(msg), "Sensor Timeout on sensor: %d", i);
-        } else {
-          snprintf(msg, sizeof(msg), "Bad reading on Sensor: %d", i);
-        }
-
-        if (Particle.connected()) { // Voorkomt queue-opbouw bij WiFi-drops
-          Particle.publish("Alerts", msg, 60, PRIVATE);
-        }
-
-        crcErrorCount[i]++;
-        continue;
+  for (int i = 0; i < eco.count; i++) {
+    if (!eco.update(i, tbus, Time.now())) { // Goede meting: in eco.centi[i], gefilterd in eco.filtered[i] (= ETopH...)
+      char msg[64];
+      if (eco.age(i, Time.now()) > 3600UL) {
+        snprintf(msg, sizeof(msg), "Sensor Timeout on sensor: %d", i);
+      } else {
+        snprintf(msg, sizeof(msg), "Bad reading on Sensor: %d", i);
       }
 
-      tmStamp[i] = Time.now();
-      int16_t raw = (scratchpadData[1] << 8) | scratchpadData[0];
-      celsius = (double)raw * 0.0625;
-      *temps[i] = celsius;
-    }
-
-    // Bouw CRC JSON
-    strcpy(crcErrorJSON, "{\"errorCount\":[");
-    for (int i = 0; i < 6; i++) {
-      char buf[8];
-      itoa(crcErrorCount[i], buf, 10);
-      strcat(crcErrorJSON, buf);
-      if (i < 5) strcat(crcErrorJSON, ",");
+      if (Particle.connected()) { // Voorkomt queue-opbouw bij WiFi-drops
+        Particle.publish("Alerts", msg, 60, PRIVATE);
+      }
     }
-    strcat(crcErrorJSON, "]}");
   }
+
+  // Bouw CRC JSON
+  eco.updateErrorJSON(crcErrorJSON, sizeof(crcErrorJSON)); // Alleen herschreven als een teller veranderde
 }
 
 
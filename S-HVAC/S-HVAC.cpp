@@ -148,6 +148,13 @@ STARTUP(System.enableFeature(FEATURE_RETAINED_MEMORY));
  #include <OneWire.h>
  const int oneWirePin = D3; // Compatible to PhotoniX shield...
  OneWire ds = OneWire(oneWirePin);
+ // Alternative backend: T-BUS on the TX pin via the UART (open-drain half duplex). No interrupts masked during the 12 sensor reads => WiFi friendly.
+ //#include <OneWireUART.h>
+ //OneWireUART ds(Serial1);
+ // Alternative for 2 buses: KS boiler on D3, KW boiler on D2 (same GPIO port). Both buses are read in lockstep => half the T-BUS time.
+ //#include <OneWireMulti.h>
+ //uint16_t oneWirePins[] = {D3, D2};
+ //OneWireMulti tbusPins(oneWirePins, 2);
 
 
 //Initialize global variables:
@@ -289,30 +296,38 @@ STARTUP(System.enableFeature(FEATURE_RETAINED_MEMORY));
   {0x28,0x78,0xF9,0x03,0x00,0x00,0x80,0x76},
   {0x28,0x70,0xAD,0x07,0x00,0x00,0x80,0x53},
   {0x28,0x40,0xE1,0x03,0x00,0x00,0x80,0x78}}; // = For 12 "DS18B20" sensors in both "KEL-WON" & "KEL-SCH" boilers.
+ // Resolution (9..12 bit) of each sensor in addrs0: 10 bit = 0.25°C steps in 188 ms instead of 0.0625°C in 750 ms (12 bit). Enough for boiler layers.
+ byte resolution0[12] = {10,10,10,10,10,10,10,10,10,10,10,10};
 
  // 2) Store addresses of DS18S20 sensors (Starting with 0x10,) here and activate "getTemperatures(1);" in loop() function:
  byte addrs1[3][8] = {{},{},{}}; // = For a number of TO92 "DS18S20" sensors (Currently none used)
 
- // Initialize the variable names of the sensors as "double" variables: (=> can be published as "Particle.variables")
- double KSTopH, KSTopL, KSMidH, KSMidL, KSBotH, KSBotL, KWTopH, KWTopL, KWMidH, KWMidL, KWBotH, KWBotL; // Names of the 12 sensors, stored in the above array(s). 12 sensors (0,1,2,3,4,5,6,7,8,9,10,11) in the KEL-SCH + KEL-WON boilers
- double* temps[] = {&KSTopH, &KSTopL, &KSMidH, &KSMidL, &KSBotH, &KSBotL, &KWTopH, &KWTopL, &KWMidH, &KWMidL, &KWBotH, &KWBotL}; // Group1: 12 waterproof sensors
-
- // Initialize the globals for time stamp (Faulty sensor reporting via CRC checking):
+ // Readings of the 12 sensors in addrs0: ROM, reading, error count and time of the last good reading, one array each. (A wrong number of ROMs in addrs0 does not compile)
+ #include <SensorArray.h>
+ SensorArray<12> boilers(addrs0); // 12 sensors (0,1,2,3,4,5,6,7,8,9,10,11) in the KEL-SCH + KEL-WON boilers
+ // Names of the 12 sensors: references into boilers.filtered[] (1/100 °C, see FixedPoint.h): median of the last 5 readings, a single bad reading does not reach the energy calculations
+ centi_t &KSTopH = boilers.filtered[0], &KSTopL = boilers.filtered[1], &KSMidH = boilers.filtered[2], &KSMidL = boilers.filtered[3], &KSBotH = boilers.filtered[4], &KSBotL = boilers.filtered[5];
+ centi_t &KWTopH = boilers.filtered[6], &KWTopL = boilers.filtered[7], &KWMidH = boilers.filtered[8], &KWMidL = boilers.filtered[9], &KWBotH = boilers.filtered[10], &KWBotL = boilers.filtered[11];
+ #include <TBus.h>
+ TBus tbus(ds, boilers.rom, boilers.count); // Non-blocking reader for the 12 sensors: loop() keeps running during the conversion
+ // With 2 buses (see OneWireMulti above): bus of each sensor in addrs0 (0 = D3, 1 = D2)
+ //byte bus0[12] = {0,0,0,0,0,0,1,1,1,1,1,1};
+ //TBus tbus(tbusPins, boilers.rom, bus0, boilers.count);
+
+ // Faulty sensor reporting via CRC checking:
  char crcErrorJSON[128];
- int crcErrorCount[sizeof(temps)/sizeof(temps[0])];
- uint32_t tmStamp[sizeof(temps)/sizeof(temps[0])];
+ char tbusJSON[400]; // T-BUS health counters (TBus::statsJSON) => Particle.variable "TBUS_health"
 
  // Initialize the global variables for temperature calculations:
  uint32_t getTemperaturesInterval = 10 * 1000; // Sample rate for temperatures = 10s
- uint32_t getTemperaturesLastTime = millis() - getTemperaturesInterval; // Reset interval to sample immediately at start-up!
- double celsius;
- double KSTmin = 25; // Minimum KS boiler temperature to calculate "spare" energy (Securing Floor Heating)
- double KWTmin = 25; // Minimum KW boiler temperature to calculate "spare" energy (Securing Floor Heating)
- double KSAv1, KSAv2, KSAv3, KSAv4, KSAv5, KSAv, KWAv1, KWAv2, KWAv3, KWAv4, KWAv5, KWAv; // To store average temperatures
- double KSQ1, KSQ2, KSQ3, KSQ4, KSQ5, KSQtot, KWQ1, KWQ2, KWQ3, KWQ4, KWQ5, KWQtot; // To store "spare" energy
+ // Energy calculations in fixed point (the Photon has no FPU): temperatures in 1/100 °C, energy in Wh (= 1/1000 kWh). Converted to °C / kWh for the JSON and the publishes only
+ centi_t KSTmin = CENTI(25); // Minimum KS boiler temperature to calculate "spare" energy (Securing Floor Heating)
+ centi_t KWTmin = CENTI(25); // Minimum KW boiler temperature to calculate "spare" energy (Securing Floor Heating)
+ centi_t KSAv1, KSAv2, KSAv3, KSAv4, KSAv5, KSAv, KWAv1, KWAv2, KWAv3, KWAv4, KWAv5, KWAv; // To store average temperatures (1/100 °C)
+ mkwh_t KSQ1, KSQ2, KSQ3, KSQ4, KSQ5, KSQtot, KWQ1, KWQ2, KWQ3, KWQ4, KWQ5, KWQtot; // To store "spare" energy (Wh)
 
  // For energy reporting of KEL-SCH boiler:
- double prev_KSQtot = 0;
+ mkwh_t prev_KSQtot = 0;
  uint32_t getKSplusInterval = 60 * 1000; // Sample rate for energy Demand: Every 1 minute
  uint32_t getKSplusLastTime = millis();
  retained double total_KSplus = 0; // Accumulated energy Demand (TOTAL) every minute
@@ -320,7 +335,7 @@ STARTUP(System.enableFeature(FEATURE_RETAINED_MEMORY));
  retained double prev_H_KSplus = 0; // Accumulated energy Demand (TOTAL) exactly on the previous hour
 
  // For energy reporting of KEL-WON boiler:
- double prev_KWQtot = 0;
+ mkwh_t prev_KWQtot = 0;
  uint32_t getKWplusInterval = 60 * 1000; // Sample rate for energy Demand: Every 1 minute
  uint32_t getKWplusLastTime = millis() + 1000; // 1s delay not to start together with KEL-SCH...
  retained double total_KWplus = 0; // Accumulated energy Demand (TOTAL) every minute
@@ -388,14 +403,17 @@ void setup()
 
 
 // *D3 - T-BUS (12 temp sensors)
- // @BulldogLowell: Initialize the timestamp array: prevent wrong messages if you get a bad CRC error on the first reading after startup...
- for (int i = 0; i < sizeof(temps)/sizeof(temps[0]); i++)
- {
-   tmStamp[i] = Time.now();
- }
+ // @BulldogLowell: Initialize the timestamps: prevent wrong messages if you get a bad CRC error on the first reading after startup...
+ boilers.begin(Time.now());
+ boilers.setLimits(CENTI(1), CENTI(99)); // Plausible boiler water temperatures: anything else is a bad reading
+ tbus.bind(0); // Auto-binding: Sensor IDs kept in EEPROM (address 0). Checked with one read per sensor, search only if one is missing. addrs0 is only used at first start-up and after it was edited.
+ tbus.setResolution(resolution0); // Write the resolution of each sensor: shorter conversion time => less T-BUS time
+ tbus.setAlarmPolling(1, 6); // Steady state: only read sensors that changed > 1°C (alarm search). Full sweep of all 12 sensors every 6th cycle (1 min).
+ tbus.setPipelined(getTemperaturesInterval); // tbus.poll() reads + starts the next conversion every 10s: readings are ready without waiting for a conversion
 
  // Report the CRC errors with sensor ID:
   //Particle.variable("CRC_Errors", crcErrorJSON, STRING); // For debugging; Creates array of errorcounts of all active sensors. Example: {"errorCount":[17,4,4,14,8,3]} => 17 = sensor 0, 4 = sensor 1, etc...
+  Particle.variable("TBUS_health", tbusJSON, STRING); // Resets, presence failures, bus timeouts, read errors per sensor ID, power writes, bytes and µs with interrupts off (estimate): spot a degrading cable before a sensor times out
 
  // Ventilation control:
   pinMode(fancontrolPin, OUTPUT);
@@ -436,61 +454,59 @@ void loop()
  delay(50);
 
 // *D3 - T-BUS (Get all system temperatures: 2 Boilers + 2 Heat Pumps, 2 ECO Pumps, 2 Floor heating pumps (= 2x 12 sensors)
- if ((millis()-getTemperaturesLastTime)>getTemperaturesInterval) // Set the sampling rate in "getTemperaturesInterval"
+ if (tbus.poll()) // Every getTemperaturesInterval (pipelined): all scratchpads are read, the next conversion of all 12 sensors is running
  {
-  // Read sensor values in array 0 and 1. (The argument selects the array of addresses (addrs0, addrs1 ...) in the "getTemperatures" function
+  // Process sensor values in array 0 and 1. (The argument selects the array of addresses (addrs0, addrs1 ...) in the "getTemperatures" function
   // TEMPORARY: Switch off next line. Activate again when boiler sensors are installed.
   getTemperatures(0); // Update all sensor variables of array 0 (DS18B20 type)
+  tbus.statsJSON(tbusJSON, sizeof(tbusJSON)); // Update "TBUS_health"
   //getTemperatures(1); // Update all sensor variables of array 1 (DS18S20 type) => Currently not used...
 
   // 294 liter KS Boiler:
   // Calculate the average KS tank temperature in each of the 5 zones:
-  KSAv1 = (KSTopH + KSTopL)/2;
-  KSAv2 = (KSTopL + KSMidH)/2;
-  KSAv3 = (KSMidH + KSMidL)/2;
-  KSAv4 = (KSMidL + KSBotH)/2;
-  KSAv5 = (KSBotH + KSBotL)/2;
-  KSAv = (KSAv1+KSAv2+KSAv3+KSAv4+KSAv5)/5;
+  KSAv1 = centiAverage(KSTopH, KSTopL);
+  KSAv2 = centiAverage(KSTopL, KSMidH);
+  KSAv3 = centiAverage(KSMidH, KSMidL);
+  KSAv4 = centiAverage(KSMidL, KSBotH);
+  KSAv5 = centiAverage(KSBotH, KSBotL);
+  KSAv = ((int32_t)KSAv1+KSAv2+KSAv3+KSAv4+KSAv5)/5;
 
   // Calculate the "spare" 294 liter KS tank energy in each of the 5 zones:
-  KSQ1 = (KSAv1-KSTmin)*66*1.163/1000; // Spare energy in 66 liter top zone (kWh)
-  KSQ2 = (KSAv2-KSTmin)*54*1.163/1000; // Spare energy in 54 liter top/mid zone (kWh)
-  KSQ3 = (KSAv3-KSTmin)*54*1.163/1000; // Spare energy in 54 liter middle zone (kWh)
-  KSQ4 = (KSAv4-KSTmin)*54*1.163/1000; // Spare energy in 54 liter mid/bottom zone (kWh)
-  KSQ5 = (KSAv5-KSTmin)*66*1.163/1000; // Spare energy in 66 liter bottom zone (kWh)
+  KSQ1 = zoneEnergy(KSAv1, KSTmin, 66); // Spare energy in 66 liter top zone (kWh)
+  KSQ2 = zoneEnergy(KSAv2, KSTmin, 54); // Spare energy in 54 liter top/mid zone (kWh)
+  KSQ3 = zoneEnergy(KSAv3, KSTmin, 54); // Spare energy in 54 liter middle zone (kWh)
+  KSQ4 = zoneEnergy(KSAv4, KSTmin, 54); // Spare energy in 54 liter mid/bottom zone (kWh)
+  KSQ5 = zoneEnergy(KSAv5, KSTmin, 66); // Spare energy in 66 liter bottom zone (kWh)
   KSQtot = KSQ1+KSQ2+KSQ3+KSQ4+KSQ5; // Total spare energy in tank (kWh)
 
   // 294 liter KW Boiler:
   // Calculate the average KW tank temperature in each of the 5 zones:
-  KWAv1 = (KWTopH + KWTopL)/2;
-  KWAv2 = (KWTopL + KWMidH)/2;
-  KWAv3 = (KWMidH + KWMidL)/2;
-  KWAv4 = (KWMidL + KWBotH)/2;
-  KWAv5 = (KWBotH + KWBotL)/2;
-  KWAv = (KWAv1+KWAv2+KWAv3+KWAv4+KWAv5)/5;
+  KWAv1 = centiAverage(KWTopH, KWTopL);
+  KWAv2 = centiAverage(KWTopL, KWMidH);
+  KWAv3 = centiAverage(KWMidH, KWMidL);
+  KWAv4 = centiAverage(KWMidL, KWBotH);
+  KWAv5 = centiAverage(KWBotH, KWBotL);
+  KWAv = ((int32_t)KWAv1+KWAv2+KWAv3+KWAv4+KWAv5)/5;
 
   // Calculate the "spare" 294 liter KW tank energy in each of the 5 zones:
-  KWQ1 = (KWAv1-KWTmin)*66*1.163/1000; // Spare energy in 66 liter top zone (kWh)
-  KWQ2 = (KWAv2-KWTmin)*54*1.163/1000; // Spare energy in 54 liter top/mid zone (kWh)
-  KWQ3 = (KWAv3-KWTmin)*54*1.163/1000; // Spare energy in 54 liter middle zone (kWh)
-  KWQ4 = (KWAv4-KWTmin)*54*1.163/1000; // Spare energy in 54 liter mid/bottom zone (kWh)
-  KWQ5 = (KWAv5-KWTmin)*66*1.163/1000; // Spare energy in 66 liter bottom zone (kWh)
+  KWQ1 = zoneEnergy(KWAv1, KWTmin, 66); // Spare energy in 66 liter top zone (kWh)
+  KWQ2 = zoneEnergy(KWAv2, KWTmin, 54); // Spare energy in 54 liter top/mid zone (kWh)
+  KWQ3 = zoneEnergy(KWAv3, KWTmin, 54); // Spare energy in 54 liter middle zone (kWh)
+  KWQ4 = zoneEnergy(KWAv4, KWTmin, 54); // Spare energy in 54 liter mid/bottom zone (kWh)
+  KWQ5 = zoneEnergy(KWAv5, KWTmin, 66); // Spare energy in 66 liter bottom zone (kWh)
   KWQtot = KWQ1+KWQ2+KWQ3+KWQ4+KWQ5; // Total spare energy in tank (kWh)
 
   // Update the Temperatures JSON string:
-  snprintf(JSON_hvac,400,"{\"KSTopH\":%.1f,\"KSTopL\":%.1f,\"KSMidH\":%.1f,\"KSMidL\":%.1f,\"KSBotH\":%.1f,\"KSBotL\":%.1f,\"KSAv\":%.1f,\"KSQtot\":%.3f,\"KWTopH\":%.1f,\"KWTopL\":%.1f,\"KWMidH\":%.1f,\"KWMidL\":%.1f,\"KWBotH\":%.1f,\"KWBotL\":%.1f,\"KWAv\":%.1f,\"KWQtot\":%.3f,\"BB\":%.0f,\"WP\":%.0f,\"BK\":%.0f,\"ZP\":%.0f,\"EP\":%.0f,\"KK\":%.0f,\"IK\":%.0f,\"R1\":%d,\"R2\":%d,\"R3\":%d,\"R4\":%d,\"R5\":%d,\"R6\":%d,\"R7\":%d,\"HeatDem\":%.1f}",KSTopH,KSTopL,KSMidH,KSMidL,KSBotH,KSBotL,KSAv,KSQtot,KWTopH,KWTopL,KWMidH,KWMidL,KWBotH,KWBotL,KWAv,KWQtot,BB_DC,WP_DC,BK_DC,ZP_DC,EP_DC,KK_DC,IK_DC,BBon,WPon,BKon,ZPon,EPon,KKon,IKon,heatdemand);
+  snprintf(JSON_hvac,400,"{\"KSTopH\":%.1f,\"KSTopL\":%.1f,\"KSMidH\":%.1f,\"KSMidL\":%.1f,\"KSBotH\":%.1f,\"KSBotL\":%.1f,\"KSAv\":%.1f,\"KSQtot\":%.3f,\"KWTopH\":%.1f,\"KWTopL\":%.1f,\"KWMidH\":%.1f,\"KWMidL\":%.1f,\"KWBotH\":%.1f,\"KWBotL\":%.1f,\"KWAv\":%.1f,\"KWQtot\":%.3f,\"BB\":%.0f,\"WP\":%.0f,\"BK\":%.0f,\"ZP\":%.0f,\"EP\":%.0f,\"KK\":%.0f,\"IK\":%.0f,\"R1\":%d,\"R2\":%d,\"R3\":%d,\"R4\":%d,\"R5\":%d,\"R6\":%d,\"R7\":%d,\"HeatDem\":%.1f}",centiToDouble(KSTopH),centiToDouble(KSTopL),centiToDouble(KSMidH),centiToDouble(KSMidL),centiToDouble(KSBotH),centiToDouble(KSBotL),centiToDouble(KSAv),mkWhToDouble(KSQtot),centiToDouble(KWTopH),centiToDouble(KWTopL),centiToDouble(KWMidH),centiToDouble(KWMidL),centiToDouble(KWBotH),centiToDouble(KWBotL),centiToDouble(KWAv),mkWhToDouble(KWQtot),BB_DC,WP_DC,BK_DC,ZP_DC,EP_DC,KK_DC,IK_DC,BBon,WPon,BKon,ZPon,EPon,KKon,IKon,heatdemand);
   //Particle.publish("Status-HEAT:HVAC", JSON_hvac,60,PRIVATE);
   delay(500);
 
   // Publish energy levels in 5 layers of the boilers in 1 string:
-  sprintf(str, "*KS: %2.1f,%2.1f,%2.1f,%2.1f,%2.1f=%2.2f(%2.0f)",KSQ1,KSQ2,KSQ3,KSQ4,KSQ5,KSQtot,KSAv);
+  sprintf(str, "*KS: %2.1f,%2.1f,%2.1f,%2.1f,%2.1f=%2.2f(%2.0f)",mkWhToDouble(KSQ1),mkWhToDouble(KSQ2),mkWhToDouble(KSQ3),mkWhToDouble(KSQ4),mkWhToDouble(KSQ5),mkWhToDouble(KSQtot),centiToDouble(KSAv));
   //Particle.publish("Status-HEAT:HVAC", str,60,PRIVATE);
   delay(500);
-  sprintf(str, "*KW: %2.1f,%2.1f,%2.1f,%2.1f,%2.1f=%2.2f(%2.0f)",KWQ1,KWQ2,KWQ3,KWQ4,KWQ5,KWQtot,KWAv);
+  sprintf(str, "*KW: %2.1f,%2.1f,%2.1f,%2.1f,%2.1f=%2.2f(%2.0f)",mkWhToDouble(KWQ1),mkWhToDouble(KWQ2),mkWhToDouble(KWQ3),mkWhToDouble(KWQ4),mkWhToDouble(KWQ5),mkWhToDouble(KWQtot),centiToDouble(KWAv));
   //Particle.publish("Status-HEAT:HVAC", str,60,PRIVATE);
-
-  // Reset the timer
-  getTemperaturesLastTime = millis();
  }
 
  // For energy reporting of KEL-SCH boiler:
@@ -1124,115 +1140,20 @@ void getDemand() // Collect & report heat demand data
 
 
 // *D3 - T-BUS (12 temp sensors)
-// @Ric's function modified by @BulldogLowell to include CRC checking + Faulty sensor reporting (many errors in given time: TIMEOUT alert!):
-void getTemperatures(int select)
-{
-    ds.reset();
-    ds.skip();
-    ds.write(0x44, 0);
-    delay(1000);
-    ds.reset();
-
-    for (int i=0; i< sizeof(temps)/sizeof(temps[0]); i++)
-    {
-        switch (select)
-        {
-            case 0:
-                ds.select(addrs0[i]);
-                break;
-            case 1:
-                ds.select(addrs1[i]);
-                break;
-        }
-
-        ds.write(0xBE,0);
-
-        byte scratchpadData[9];
-        for (int i = 0; i < 9; i++) // we only need 9 bytes
-        {
-          scratchpadData[i] = ds.read();
-        }
-
-        byte currentCRC = (OneWire::crc8(scratchpadData, 8));
-
-        ds.reset();
-
-        if (currentCRC != scratchpadData[8])
-        {
-            String message;
-            if (Time.now() - tmStamp[i] > 3600UL)  // one hour in this example
-            {
-                message = "Sensor Timeout on sensor: ";
-            }
-            else
-            {
-               //message = "Bad reading on Sensor: "; Temporarily disconnected until KW sensors are connected.
-            }
-            //Particle.publish("Alert", message + String(i), 60, PRIVATE);
-            crcErrorCount[i]++;
-            delay(1000);
-            continue;
-        }
-
-        tmStamp[i] = Time.now();
-
-        if (select == 0)
-        {
-            //int16_t raw = (data1 << 8) | data0;
-            int16_t raw = (scratchpadData[1] << 8) | scratchpadData[0];
-            celsius = (double)raw * 0.0625;
-        }
-        else if (select == 1)
-        {
-            int16_t raw = scratchpadData[0];
-            celsius = (double)raw * 0.5;
-        }
-        // construct the CRC error array
-        strcpy(crcErrorJSON, "{\"errorCount\":[");
-        for (int i = 0; i < sizeof(temps)/sizeof(temps[0]); i++)
-        {
-            char buffer[10];
-            itoa(crcErrorCount[i], buffer, 10);
-            strcat(crcErrorJSON, buffer);
-            if(i < sizeof(temps)/sizeof(temps[0]) - 1)
-              strcat(crcErrorJSON, ",");
-        }
-        strcat(crcErrorJSON, "]}");
-        *temps[i] = celsius;
-    }
-}
+// getTemperatures() is in its own file: the PC simulation (SIM/SIM.cpp) compiles the same code.
+#include "getTemperatures.h"
 
 
 
 
 
-void discoverOneWireDevices(void) // List the addresses of all 1-wire devices on the T-BUS (D3) => discoverOneWireDevices();
+void discoverOneWireDevices(void) // List the addresses of all 1-wire devices on the T-BUS (D3) in one JSON event => discoverOneWireDevices();
 {
-  byte i;
-  byte present = 0;
-  byte data[12];
-  byte addr[12];
-  int sensorCount = 0;
-
-  Particle.publish("OneWire", "Looking for 1-wire addresses:", 60, PRIVATE); delay(1000);
-
-  while(ds.search(addr) and sensorCount < 13)
-  {
-    sensorCount++;
-    char newAddress[96] = ""; // Make space for the (12 x 8 =) 96 characters of our 12 sensor addresses.
-    snprintf(newAddress, sizeof(newAddress), "0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X", addr[0], addr[1], addr[2], addr[3], addr[4], addr[5], addr[6], addr[7], addr[8], addr[9], addr[10], addr[11]);
-    Particle.publish("OneWire", newAddress, 60, PRIVATE); delay(1000);
-
-    if ( OneWire::crc8( addr, 7) != addr[7])
-    {
-      Particle.publish("OneWire", "CRC is not valid!", 60, PRIVATE); delay(1000);
-      return;
-    }
-  }
-
-  ds.reset_search();
-  Particle.publish("OneWire", "No more addresses!", 60, PRIVATE); delay(1000);
-  return;
+  // A new sensor takes over the slot of a missing one (like the TOP-H replacement of 28oct19) and is stored in EEPROM: No reflash needed!
+  char romJSON[400]; // 12 x 19 characters + missing/new slots
+  tbus.scan(); // Full search of the T-BUS
+  tbus.romJSON(romJSON, sizeof(romJSON)); // Example: {"roms":["28DBB503000080BB",...],"new":[0],"miss":[]}
+  Particle.publish("OneWire", romJSON, 60, PRIVATE);
 }
 
 
@@ -1242,11 +1163,11 @@ void discoverOneWireDevices(void) // List the addresses of all 1-wire devices on
 // For energy reporting of KEL-SCH boiler:
 void getKSplus()
 {
-  double minute_KSplus = KSQtot - prev_KSQtot;
+  mkwh_t minute_KSplus = KSQtot - prev_KSQtot; // Wh
 
   if (minute_KSplus > 0)
   {
-    total_KSplus = total_KSplus + minute_KSplus;
+    total_KSplus = total_KSplus + mkWhToDouble(minute_KSplus); // Retained totals stay in kWh
     //Particle.publish("Status-HEAT:HVAC", "KSQtot UP!",60,PRIVATE);
   }
   else
@@ -1261,7 +1182,7 @@ void getKSplus()
     hour_KSplus = total_KSplus - prev_H_KSplus;
     prev_H_KSplus = total_KSplus;
   }
-  sprintf(str, "KS energy,kWh: %2.2f-Diff: %2.2f",KSQtot,minute_KSplus);
+  sprintf(str, "KS energy,kWh: %2.2f-Diff: %2.2f",mkWhToDouble(KSQtot),mkWhToDouble(minute_KSplus));
   //Particle.publish("Status-HEAT:HVAC", str,60,PRIVATE);
   delay(500);
   sprintf(str, "KS-plus,kWh: Hourly: %2.2f-Total: %2.2f",hour_KSplus,total_KSplus);
@@ -1275,11 +1196,11 @@ void getKSplus()
 // For energy reporting of KEL-WON boiler:
 void getKWplus()
 {
-  double minute_KWplus = KWQtot - prev_KWQtot;
+  mkwh_t minute_KWplus = KWQtot - prev_KWQtot; // Wh
 
   if (minute_KWplus > 0)
   {
-    total_KWplus = total_KWplus + minute_KWplus;
+    total_KWplus = total_KWplus + mkWhToDouble(minute_KWplus); // Retained totals stay in kWh
     //Particle.publish("Status-HEAT:HVAC", "KWQtot UP!",60,PRIVATE);
   }
   else
@@ -1294,7 +1215,7 @@ void getKWplus()
     hour_KWplus = total_KWplus - prev_H_KWplus;
     prev_H_KWplus = total_KWplus;
   }
-  sprintf(str, "KW energy,kWh: %2.2f-Diff: %2.2f",KWQtot,minute_KWplus);
+  sprintf(str, "KW energy,kWh: %2.2f-Diff: %2.2f",mkWhToDouble(KWQtot),mkWhToDouble(minute_KWplus));
   //Particle.publish("Status-HEAT:HVAC", str,60,PRIVATE);
   delay(500);
   sprintf(str, "KW-plus,kWh: Hourly: %2.2f-Total: %2.2f",hour_KWplus,total_KWplus);
@@ -0,0 +1,43 @@
+#ifndef getTemperatures_h
+#define getTemperatures_h
+
+// getTemperatures() of S-HVAC, in its own file so the PC simulation
+// (SIM/SIM.cpp) compiles exactly the code that runs on the Photon.
+// Include it after the globals it uses: boilers (SensorArray), tbus (TBus)
+// and crcErrorJSON[].
+
+// 1 = publish an "Alert" for every bad reading. Off in S-HVAC: temporarily
+// disconnected until the KW sensors are connected. The SIM switches it on.
+#ifndef HVAC_SENSOR_ALERTS
+#define HVAC_SENSOR_ALERTS 0
+#endif
+
+// *D3 - T-BUS (12 temp sensors)
+// @Ric's function modified by @BulldogLowell to include CRC checking + Faulty sensor reporting (many errors in given time: TIMEOUT alert!):
+// The conversion and scratchpad reading is done by tbus (non-blocking), this function only processes the collected readings.
+// The argument selects the array of addresses (0 = addrs0): only addrs0 is in use.
+void getTemperatures(int /* select */)
+{
+    for (int i=0; i< boilers.count; i++)
+    {
+        if (!tbus.fresh(i)) continue; // Alarm polling: not read in this cycle, keeps its last reading
+        if (!boilers.update(i, tbus, Time.now())) // Good reading: stored in boilers.centi[i] and filtered into boilers.filtered[i] (= KSTopH...) in the DS18B20 or DS18S20 scale of its family code
+        {
+#if HVAC_SENSOR_ALERTS
+            String message;
+            if (boilers.age(i, Time.now()) > 3600UL)  // one hour in this example
+            {
+                message = "Sensor Timeout on sensor: ";
+            }
+            else
+            {
+               message = "Bad reading on Sensor: ";
+            }
+            Particle.publish("Alert", message + String(i), 60, PRIVATE);
+#endif
+        }
+    }
+    boilers.updateErrorJSON(crcErrorJSON, sizeof(crcErrorJSON)); // construct the CRC error array (only when a count changed)
+}
+
+#endif // getTemperatures_h
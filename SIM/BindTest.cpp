@@ -0,0 +1,85 @@
+/*
+
+BindTest - The EEPROM ROM table of TBus::bind() across simulated reboots.
+
+Each "boot" builds a new TBus on the compiled table, as the Photon does after
+a reset, and binds it to the same EEPROM record:
+1. first boot: nothing stored, the seed is used and saved
+2. a sensor is replaced: bind() rebinds the slot and saves it
+3. reboot with the same seed: the replacement comes from EEPROM
+4. a corrupted bit in the record: ignored, the seed is used (and rebound)
+5. reboot after addrs0 was edited in the sketch: the new seed wins
+
+Usage: bind-test
+Exit code 0 = all OK.
+
+*/
+
+#include "application.h"
+#include "OneWireSim.h"
+#include "TBus.h"
+
+static const uint8_t seed0[3][8] =
+{{0x28,0xDB,0xB5,0x03,0x00,0x00,0x80,0xBB},
+ {0x28,0x7C,0xF0,0x03,0x00,0x00,0x80,0x59},
+ {0x28,0x72,0xDB,0x03,0x00,0x00,0x80,0xC2}};
+static const uint8_t spareRom[8] = {0x28,0x11,0x22,0x33,0x00,0x00,0x80,0x00};
+
+static int failures = 0;
+
+#define CHECK(cond, ...) \
+    if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); failures++; }
+
+// One boot: the compiled table 'seed', bound to EEPROM address 0.
+// Returns the number of rebound slots, the table after bind() in 'roms'.
+static uint8_t boot(OneWireSim &ds, const uint8_t (*seed)[8], uint8_t (*roms)[8])
+{
+    memcpy(roms, seed, 3 * 8);
+    TBus tbus(ds, roms, 3);
+
+    return tbus.bind(0);
+}
+
+int main(void)
+{
+    OneWireSim ds;
+    DS18B20Sim s0(seed0[0]), s1(seed0[1]), s2(seed0[2]), spare(spareRom);
+    uint8_t roms[3][8];
+    uint8_t edited[3][8];
+
+    ds.attach(&s0);
+    ds.attach(&s1);
+    ds.attach(&s2);
+    ds.attach(&spare);
+    spare.present = false;
+    EEPROM.clear();
+
+    CHECK(boot(ds, seed0, roms) == 0, "first boot rebinds nothing");
+    CHECK(EEPROM.read(0) == TBUS_EEPROM_MARKER, "first boot saves the record");
+
+    s0.present = false;
+    spare.present = true;
+    CHECK(boot(ds, seed0, roms) == 1, "replaced sensor is rebound");
+    CHECK(memcmp(roms[0], spare.rom(), 8) == 0, "slot 0 takes the spare");
+
+    CHECK(boot(ds, seed0, roms) == 0, "reboot rebinds nothing");
+    CHECK(memcmp(roms[0], spare.rom(), 8) == 0, "slot 0 loaded from EEPROM");
+
+    // One flipped bit in the stored ROM of slot 2: the record is dropped, the
+    // seed used, and slot 0 rebound to the spare again
+    EEPROM.write(4 + 8 * 2 + 3, EEPROM.read(4 + 8 * 2 + 3) ^ 0x04);
+    CHECK(boot(ds, seed0, roms) == 1, "corrupt record: slot 0 rebound");
+    CHECK(memcmp(roms[2], seed0[2], 8) == 0, "corrupt record ignored");
+
+    // addrs0 edited: slot 0 gets the spare's ROM, slots 1 and 2 swapped
+    memcpy(edited[0], spare.rom(), 8);
+    memcpy(edited[1], seed0[2], 8);
+    memcpy(edited[2], seed0[1], 8);
+    CHECK(boot(ds, edited, roms) == 0, "edited seed rebinds nothing");
+    CHECK(memcmp(roms, edited, sizeof(roms)) == 0, "edited seed wins over EEPROM");
+    CHECK(boot(ds, edited, roms) == 0 && memcmp(roms, edited, sizeof(roms)) == 0, "edited seed saved");
+
+    printf(failures ? "%d FAILURES\n" : "ALL OK\n", failures);
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,137 @@
+/*
+
+CRCTest - The table-driven CRC8/CRC16 of OneWire against the bitwise code on the PC.
+
+OneWire::crc8(), crc8_update() and crc16() (lookup tables, the default
+ONEWIRE_CRC8_TABLE / ONEWIRE_CRC16_TABLE build) must give exactly what the
+bitwise versions gave: same CRC for every buffer, length and seed. The
+bitwise versions are copied below as the reference. Also checks the
+standard check values ("123456789") and a ROM of S-HVAC, then times both
+variants on a scratchpad (crc8, 8 bytes) and a DS2408 frame (crc16, 11 bytes).
+
+Usage: crc-test [buffers]   (random buffers per length, default 10000)
+Exit code 0 = all equal.
+
+*/
+
+#include "application.h"
+#include "OneWire.h"
+#include <chrono>
+
+// Reference: the bitwise crc8 of OneWire before the table (ONEWIRE_CRC8_TABLE 0)
+static uint8_t crc8Bitwise(const uint8_t *addr, uint8_t len, uint8_t crc = 0)
+{
+    while (len--) {
+        uint8_t inbyte = *addr++;
+        for (uint8_t i = 8; i; i--) {
+            uint8_t mix = (crc ^ inbyte) & 0x01;
+            crc >>= 1;
+            if (mix) crc ^= 0x8C;
+            inbyte >>= 1;
+        }
+    }
+
+    return crc;
+}
+
+// Reference: the bitwise crc16 of OneWire before the table (ONEWIRE_CRC16_TABLE 0)
+static uint16_t crc16Bitwise(const uint8_t *input, uint16_t len, uint16_t crc = 0)
+{
+    static const uint8_t oddparity[16] =
+        { 0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0 };
+
+    for (uint16_t i = 0 ; i < len ; i++) {
+        uint16_t cdata = input[i];
+        cdata = (cdata ^ crc) & 0xff;
+        crc >>= 8;
+
+        if (oddparity[cdata & 0x0F] ^ oddparity[cdata >> 4])
+            crc ^= 0xC001;
+
+        cdata <<= 6;
+        crc ^= cdata;
+        cdata <<= 1;
+        crc ^= cdata;
+    }
+
+    return crc;
+}
+
+static int failures = 0;
+
+#define CHECK(cond, ...) \
+    if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); failures++; }
+
+// Nanoseconds per call of f(), best of 5 runs of 'n' calls
+template <typename F>
+static double nsPerCall(F f, uint32_t n)
+{
+    double best = 1e9;
+
+    for (int run = 0; run < 5; run++) {
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        for (uint32_t k = 0; k < n; k++) f(k);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / n;
+        if (ns < best) best = ns;
+    }
+
+    return best;
+}
+
+int main(int argc, char *argv[])
+{
+    int buffers = (argc > 1) ? atoi(argv[1]) : 10000;
+    uint8_t buf[64];
+    uint8_t check[9] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+    uint8_t rom[8] = { 0x28, 0xDB, 0xB5, 0x03, 0x00, 0x00, 0x80, 0xBB };    // KSTopH of S-HVAC
+    volatile uint32_t sink = 0;
+
+    // Standard check values: CRC-8/MAXIM = 0xA1, CRC-16/ARC = 0xBB3D
+    CHECK(OneWire::crc8(check, 9) == 0xA1, "crc8(\"123456789\") = %02X", OneWire::crc8(check, 9));
+    CHECK(OneWire::crc16(check, 9) == 0xBB3D, "crc16(\"123456789\") = %04X", OneWire::crc16(check, 9));
+    CHECK(OneWire::crc8(rom, 7) == rom[7], "ROM CRC %02X", OneWire::crc8(rom, 7));
+    CHECK(OneWire::crc8(rom, 8) == 0, "ROM + CRC should give 0");
+
+    // Every byte value through crc8_update(), from every running CRC
+    for (int crc = 0; crc < 256; crc++) {
+        for (int v = 0; v < 256; v++) {
+            uint8_t b = v;
+            CHECK(OneWire::crc8_update(crc, v) == crc8Bitwise(&b, 1, crc), "crc8_update(%02X, %02X)", crc, v);
+        }
+    }
+
+    // Random buffers of 1..64 bytes, random seed for crc16
+    srand(1);
+    for (int len = 1; len <= 64; len++) {
+        for (int k = 0; k < buffers; k++) {
+            uint16_t seed = (k & 1) ? rand() & 0xFFFF : 0;
+            uint8_t inverted[2];
+            uint16_t crc;
+
+            for (int i = 0; i < len; i++) buf[i] = rand();
+
+            CHECK(OneWire::crc8(buf, len) == crc8Bitwise(buf, len), "crc8 len %d", len);
+            crc = crc16Bitwise(buf, len, seed);
+            CHECK(OneWire::crc16(buf, len, seed) == crc, "crc16 len %d seed %04X", len, seed);
+
+            inverted[0] = ~crc & 0xFF;
+            inverted[1] = ~crc >> 8;
+            CHECK(OneWire::check_crc16(buf, len, inverted, seed), "check_crc16 len %d", len);
+        }
+        if (failures) break;
+    }
+    printf("crc8/crc16: table == bitwise for %d buffers of 1..64 bytes%s\n", buffers * 64, failures ? ": NO" : "");
+
+    // Benchmark
+    for (int i = 0; i < 64; i++) buf[i] = rand();
+    printf("crc8  8 bytes: table %6.1f ns, bitwise %6.1f ns\n",
+           nsPerCall([&](uint32_t k) { buf[0] = k; sink += OneWire::crc8(buf, 8); }, 1000000),
+           nsPerCall([&](uint32_t k) { buf[0] = k; sink += crc8Bitwise(buf, 8); }, 1000000));
+    printf("crc16 11 bytes: table %6.1f ns, bitwise %6.1f ns\n",
+           nsPerCall([&](uint32_t k) { buf[0] = k; sink += OneWire::crc16(buf, 11); }, 1000000),
+           nsPerCall([&](uint32_t k) { buf[0] = k; sink += crc16Bitwise(buf, 11); }, 1000000));
+
+    printf(failures ? "%d FAILURES\n" : "ALL OK\n", failures);
+
+    return failures ? 1 : 0;
+}
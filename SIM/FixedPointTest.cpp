@@ -0,0 +1,109 @@
+/*
+
+FixedPointTest - The fixed-point boiler energy of FixedPoint.h against the old double code.
+
+S-HVAC computes the spare energy of the KS boiler from its 6 sensors: 5 zone
+averages and 5 zone energies (66/54/54/54/66 liter above KSTmin). This runs
+that calculation on random 10 bit readings (0.25 °C steps, 20..90 °C) both
+ways, the double code S-HVAC had before FixedPoint.h and the centi_t/mkwh_t
+code it has now, checks that KSQtot stays within 0.01 kWh, checks a few
+conversions, then times one update of both.
+
+The PC has a hardware FPU: its timings are the worst case for the fixed-point
+code. On the Photon (no FPU) every double operation is a soft-float call.
+
+Usage: fixedpoint-test [updates]   (random boiler updates, default 100000)
+Exit code 0 = all OK.
+
+*/
+
+#include "application.h"
+#include "FixedPoint.h"
+#include <chrono>
+
+static int failures = 0;
+
+#define CHECK(cond, ...) \
+    if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); failures++; }
+
+// Nanoseconds per call of f(), best of 5 runs of 'n' calls
+template <typename F>
+static double nsPerCall(F f, uint32_t n)
+{
+    double best = 1e9;
+
+    for (int run = 0; run < 5; run++) {
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        for (uint32_t k = 0; k < n; k++) f(k);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / n;
+        if (ns < best) best = ns;
+    }
+
+    return best;
+}
+
+// KSQtot of S-HVAC before FixedPoint.h (kWh)
+static double ksEnergyDouble(const int16_t *raw)
+{
+    double t[6], av[5];
+    double KSTmin = 25;
+
+    for (int i = 0; i < 6; i++) t[i] = raw[i] * 0.0625;
+    for (int z = 0; z < 5; z++) av[z] = (t[z] + t[z + 1]) / 2;
+
+    return (av[0]-KSTmin)*66*1.163/1000 + (av[1]-KSTmin)*54*1.163/1000 + (av[2]-KSTmin)*54*1.163/1000 +
+           (av[3]-KSTmin)*54*1.163/1000 + (av[4]-KSTmin)*66*1.163/1000;
+}
+
+// KSQtot of S-HVAC now (Wh)
+static mkwh_t ksEnergyFixed(const int16_t *raw)
+{
+    centi_t t[6], av[5];
+    centi_t KSTmin = CENTI(25);
+
+    for (int i = 0; i < 6; i++) t[i] = rawToCenti(raw[i]);
+    for (int z = 0; z < 5; z++) av[z] = centiAverage(t[z], t[z + 1]);
+
+    return zoneEnergy(av[0], KSTmin, 66) + zoneEnergy(av[1], KSTmin, 54) + zoneEnergy(av[2], KSTmin, 54) +
+           zoneEnergy(av[3], KSTmin, 54) + zoneEnergy(av[4], KSTmin, 66);
+}
+
+int main(int argc, char *argv[])
+{
+    int updates = (argc > 1) ? atoi(argv[1]) : 100000;
+    int16_t *raw = new int16_t[6 * updates];
+    double maxDiff = 0;
+    volatile double dsink = 0;
+    volatile int32_t isink = 0;
+
+    // Conversions
+    CHECK(rawToCenti(0x0191) == 2506, "rawToCenti(25.0625 °C) = %d", rawToCenti(0x0191));
+    CHECK(rawToCenti(-0x0191) == -2506, "rawToCenti(-25.0625 °C) = %d", rawToCenti(-0x0191));
+    CHECK(rawToCenti(0x0550) == 8500, "rawToCenti(85 °C) = %d", rawToCenti(0x0550));
+    CHECK(raw9ToCenti(-1) == -50, "raw9ToCenti(-0.5 °C) = %d", raw9ToCenti(-1));
+    CHECK(divRound(5, 2) == 3 && divRound(-5, 2) == -3, "divRound halves away from zero");
+    CHECK(MKWH(15) == 15000, "MKWH(15) = %ld", (long)MKWH(15));
+    CHECK(zoneEnergy(CENTI(85), CENTI(25), 110) == 7676, "110 liter at 60 K = %ld Wh", (long)zoneEnergy(CENTI(85), CENTI(25), 110));
+
+    // Random 10 bit boiler readings
+    srand(1);
+    for (int k = 0; k < 6 * updates; k++) raw[k] = (20 * 16 + rand() % (70 * 16)) & ~3;
+
+    for (int k = 0; k < updates; k++) {
+        double diff = fabs(ksEnergyDouble(&raw[6 * k]) - mkWhToDouble(ksEnergyFixed(&raw[6 * k])));
+        if (diff > maxDiff) maxDiff = diff;
+    }
+    CHECK(maxDiff < 0.01, "KSQtot differs %.4f kWh", maxDiff);
+    printf("KSQtot: fixed == double within %.4f kWh for %d updates\n", maxDiff, updates);
+
+    // Benchmark
+    printf("KS boiler update: double %6.1f ns, fixed %6.1f ns\n",
+           nsPerCall([&](uint32_t k) { dsink += ksEnergyDouble(&raw[6 * (k % updates)]); }, updates),
+           nsPerCall([&](uint32_t k) { isink += ksEnergyFixed(&raw[6 * (k % updates)]); }, updates));
+
+    printf(failures ? "%d FAILURES\n" : "ALL OK\n", failures);
+
+    delete[] raw;
+
+    return failures ? 1 : 0;
+}
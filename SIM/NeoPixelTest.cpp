@@ -0,0 +1,178 @@
+/*
+
+NeoPixelTest - Golden frames of NeoPixelEncode.h (byte order, SPI waveform) on the PC.
+
+For every pixel type: neoPixelPack() of a few colors against the frames the
+strips expect (GRB, RGB, RBG, the TM1829 red = 255 quirk), the packing
+against the switch on 'type' that neopixel.cpp had before, and
+neoPixelUnpack() back. For the SPI output: golden SPI bytes of a pixel,
+with and without a level table, every byte value decoded back from its
+waveform, and the high times against the WS2812B datasheet at the SPI
+clock of neopixel.cpp (60 MHz / 16). Then times both functions.
+
+The bit-banged loops of neopixel.cpp (cycle-counted asm, interrupts off)
+do not run here: they send the same bitstream as the reference below
+(buffer in memory order, each byte through level[], MSB first).
+
+Usage: neopixel-test
+Exit code 0 = all OK.
+
+*/
+
+#include "application.h"
+#include "NeoPixelEncode.h"
+#include <chrono>
+
+static int failures = 0;
+
+#define CHECK(cond, ...) \
+    if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); failures++; }
+
+// Nanoseconds per call of f(), best of 5 runs of 'n' calls
+template <typename F>
+static double nsPerCall(F f, uint32_t n)
+{
+    double best = 1e9;
+
+    for (int run = 0; run < 5; run++) {
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        for (uint32_t k = 0; k < n; k++) f(k);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / n;
+        if (ns < best) best = ns;
+    }
+
+    return best;
+}
+
+// Reference: setPixelColor() of neopixel.cpp before NeoPixelEncode.h
+static void packSwitch(uint8_t type, uint8_t *p, uint8_t r, uint8_t g, uint8_t b)
+{
+    switch(type) {
+      case WS2812B: // WS2812 & WS2812B is GRB order.
+      case WS2812B2:
+        *p++ = g;
+        *p++ = r;
+        *p = b;
+        break;
+      case TM1829: // TM1829 is special RBG order
+        if(r == 255) r = 254; // 255 on RED channel causes display to be in a special mode.
+        *p++ = r;
+        *p++ = b;
+        *p = g;
+        break;
+      case WS2811: // WS2811 is RGB order
+      case TM1803: // TM1803 is RGB order
+      default:     // default is RGB order
+        *p++ = r;
+        *p++ = g;
+        *p = b;
+        break;
+    }
+}
+
+// Reference: bit n of the stream the bit-banged loops send
+static uint8_t streamBit(const uint8_t *bytes, const uint8_t *level, size_t n)
+{
+    uint8_t v = level ? level[bytes[n / 8]] : bytes[n / 8];
+
+    return (v >> (7 - n % 8)) & 1;
+}
+
+// A frame of 4 pixels: red, green, blue 100, (1, 2, 3)
+static const uint8_t colors[4][3] = {{255, 0, 0}, {0, 255, 0}, {0, 0, 100}, {1, 2, 3}};
+
+static const struct {
+    uint8_t type;
+    const char *name;
+    uint8_t frame[12];
+} golden[] = {
+    { WS2812,   "WS2812",   { 0x00,0xFF,0x00, 0xFF,0x00,0x00, 0x00,0x00,0x64, 0x02,0x01,0x03 } },
+    { WS2812B,  "WS2812B",  { 0x00,0xFF,0x00, 0xFF,0x00,0x00, 0x00,0x00,0x64, 0x02,0x01,0x03 } },
+    { WS2812B2, "WS2812B2", { 0x00,0xFF,0x00, 0xFF,0x00,0x00, 0x00,0x00,0x64, 0x02,0x01,0x03 } },
+    { WS2811,   "WS2811",   { 0xFF,0x00,0x00, 0x00,0xFF,0x00, 0x00,0x00,0x64, 0x01,0x02,0x03 } },
+    { TM1803,   "TM1803",   { 0xFF,0x00,0x00, 0x00,0xFF,0x00, 0x00,0x00,0x64, 0x01,0x02,0x03 } },
+    { TM1829,   "TM1829",   { 0xFE,0x00,0x00, 0x00,0x00,0xFF, 0x00,0x64,0x00, 0x01,0x03,0x02 } },
+};
+
+int main(void)
+{
+    uint8_t level[256];
+    uint8_t frame[12], ref[3], spi[4 * 150];
+    volatile uint32_t sink = 0;
+
+    for (int v = 0; v < 256; v++) level[v] = (v * v + 255) / 256;    // a gamma-like table
+
+    // Golden frames per type
+    for (size_t t = 0; t < sizeof(golden) / sizeof(golden[0]); t++) {
+        for (int k = 0; k < 4; k++) neoPixelPack(golden[t].type, &frame[3 * k], colors[k][0], colors[k][1], colors[k][2]);
+        CHECK(memcmp(frame, golden[t].frame, 12) == 0, "%s frame", golden[t].name);
+
+        // neoPixelUnpack() gives the color back (TM1829: red 254)
+        uint32_t c = neoPixelUnpack(golden[t].type, &frame[0]);
+        CHECK(c == ((golden[t].type == TM1829) ? 0xFE0000UL : 0xFF0000UL), "%s unpack %06lX", golden[t].name, (unsigned long)c);
+    }
+
+    // Same bytes as the old switch, every value on every channel
+    for (size_t t = 0; t < sizeof(golden) / sizeof(golden[0]); t++) {
+        for (int v = 0; v < 256; v++) {
+            uint8_t got[3];
+
+            for (int ch = 0; ch < 3; ch++) {
+                uint8_t rgb[3] = {0x12, 0x34, 0x56};
+                rgb[ch] = v;
+                neoPixelPack(golden[t].type, got, rgb[0], rgb[1], rgb[2]);
+                packSwitch(golden[t].type, ref, rgb[0], rgb[1], rgb[2]);
+                CHECK(memcmp(got, ref, 3) == 0, "%s channel %d value %d", golden[t].name, ch, v);
+            }
+        }
+    }
+
+    // Golden SPI bytes: WS2812B red (00 FF 00), as is and through level[]
+    static const uint8_t spiRed[12] = { 0x88,0x88,0x88,0x88, 0xEE,0xEE,0xEE,0xEE, 0x88,0x88,0x88,0x88 };
+    neoPixelPack(WS2812B, frame, 255, 0, 0);
+    CHECK(neoPixelEncodeSPI(frame, 3, NULL, spi) == spi + 12, "SPI length");
+    CHECK(memcmp(spi, spiRed, 12) == 0, "SPI red");
+
+    static const uint8_t spiBlue100[4] = { 0x88,0xE8,0xE8,0x88 };    // level[100] = 0x28: 0010 -> 1000 1000 1110 1000, 1000 -> 1110 1000 1000 1000
+    neoPixelPack(WS2812B, frame, 0, 0, 100);
+    neoPixelEncodeSPI(&frame[2], 1, level, spi);
+    CHECK(level[100] == 0x28 && memcmp(spi, spiBlue100, 4) == 0, "SPI blue 100 through level[]");
+
+    // Every byte value: the SPI waveform decodes back to the reference bitstream
+    uint8_t all[256];
+    for (int v = 0; v < 256; v++) all[v] = v;
+    for (int useLevel = 0; useLevel < 2; useLevel++) {
+        const uint8_t *lut = useLevel ? level : NULL;
+
+        for (int half = 0; half < 2; half++) {    // spi[] holds 150 bytes: 128 at a time
+            neoPixelEncodeSPI(all + 128 * half, 128, lut, spi);
+            for (size_t n = 0; n < 128 * 8; n++) {
+                uint8_t nibble = (spi[n / 2] >> ((n & 1) ? 0 : 4)) & 0x0F;
+                CHECK(nibble == 0x8 || nibble == 0xE, "SPI nibble %X", nibble);
+                CHECK((nibble == 0xE) == streamBit(all + 128 * half, lut, n), "bit %u of byte %u", (unsigned)(n % 8), (unsigned)(128 * half + n / 8));
+                if (failures) break;
+            }
+        }
+    }
+
+    // WS2812B timing at 60 MHz / 16: one SPI bit = 267 ns
+    // Datasheet: T0H 220..380 ns, T1H 580..1000 ns, bit 1.25 us +/- 600 ns
+    double spiBitNs = 16 * 1000.0 / 60;
+    CHECK(1 * spiBitNs >= 220 && 1 * spiBitNs <= 380, "T0H %.0f ns", 1 * spiBitNs);
+    CHECK(3 * spiBitNs >= 580 && 3 * spiBitNs <= 1000, "T1H %.0f ns", 3 * spiBitNs);
+    CHECK(4 * spiBitNs >= 650 && 4 * spiBitNs <= 1850, "bit %.0f ns", 4 * spiBitNs);
+
+    printf("NeoPixelEncode: %u pixel types, 256 byte values%s\n",
+           (unsigned)(sizeof(golden) / sizeof(golden[0])), failures ? ": NO" : "");
+
+    // Benchmark: one 50 pixel frame
+    uint8_t strip[150];
+    for (int k = 0; k < 150; k++) strip[k] = rand();
+    double packNs = nsPerCall([&](uint32_t k) { for (int p = 0; p < 50; p++) neoPixelPack(WS2812B, &strip[3 * p], k, p, 7); sink += strip[k % 150]; }, 100000);
+    double spiNs = nsPerCall([&](uint32_t k) { strip[0] = k; sink += *(neoPixelEncodeSPI(strip, 150, level, spi) - 1); }, 100000);
+    printf("50 pixels: pack %6.1f ns, SPI encode %6.1f ns (%.2f ns/byte)\n", packNs, spiNs, spiNs / 150);
+
+    printf(failures ? "%d FAILURES\n" : "ALL OK\n", failures);
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,268 @@
+/*
+
+OneWireSim - Virtual 1-Wire bus with simulated DS18B20 / DS18S20 sensors (see OneWireSim.h).
+
+Models what the T-BUS code relies on: presence pulse, Match ROM, Skip ROM,
+(conditional) Search ROM, Convert T with the conversion time of the
+configured resolution, Read/Write/Copy Scratchpad, the EEPROM reload at
+power-up and the alarm flag.
+Injectable faults: CRC errors on scratchpad reads, a missing sensor and a
+shorted bus.
+
+*/
+
+#include "OneWireSim.h"
+
+uint64_t sim_micros = 0;
+uint32_t sim_irq_off = 0;
+EEPROMClass EEPROM;
+TimeClass Time;
+ParticleClass Particle;
+
+const uint8_t DS18B20Sim::powerUp[9] = { 0x50, 0x05, 0x4B, 0x46, 0x7F, 0xFF, 0x0C, 0x10, 0x00 };
+
+DS18B20Sim::DS18B20Sim(const uint8_t rom[8], double celsius)
+    : celsius(celsius), crcErrorRate(0), present(true), _eepromWrites(0),
+      _state(IDLE), _byte(0), _bit(0), _searchPhase(0), _conversionDone(0), _conversions(0), _alarm(false)
+{
+    memcpy(_rom, rom, 8);
+    _rom[7] = OneWire::crc8(_rom, 7);
+
+    memcpy(_scratchpad, powerUp, 9);
+    if (isDS18S20()) {
+        _scratchpad[0] = 0xAA;    // 85 °C at 0.5 °C per LSB
+        _scratchpad[1] = 0x00;
+        _scratchpad[4] = 0xFF;
+    }
+    _scratchpad[8] = OneWire::crc8(_scratchpad, 8);
+    memcpy(_eeprom, &_scratchpad[2], 3);
+}
+
+void DS18B20Sim::powerCycle(void)
+{
+    _scratchpad[0] = isDS18S20() ? 0xAA : 0x50;    // 85 °C
+    _scratchpad[1] = isDS18S20() ? 0x00 : 0x05;
+    memcpy(&_scratchpad[2], _eeprom, 3);
+    _scratchpad[8] = OneWire::crc8(_scratchpad, 8);
+    _conversionDone = 0;
+    _alarm = false;
+    _state = IDLE;
+}
+
+void DS18B20Sim::busReset(uint64_t now)
+{
+    finishConversion(now);
+
+    _state = ROM_CMD;
+    _byte = 0;
+    _bit = 0;
+}
+
+void DS18B20Sim::finishConversion(uint64_t now)
+{
+    int16_t raw;
+
+    if (!_conversionDone || now < _conversionDone) return;
+
+    if (isDS18S20()) {
+        raw = (int16_t)lround(celsius * 2);
+        _alarm = (int8_t)(raw >> 1) >= (int8_t)_scratchpad[2] || (int8_t)(raw >> 1) <= (int8_t)_scratchpad[3];
+    }
+    else {
+        raw = (int16_t)lround(celsius * 16);
+        raw &= ~((1 << (12 - resolution())) - 1);    // undefined bits read as 0 here
+        _alarm = (int8_t)(raw >> 4) >= (int8_t)_scratchpad[2] || (int8_t)(raw >> 4) <= (int8_t)_scratchpad[3];
+    }
+
+    _scratchpad[0] = raw & 0xFF;
+    _scratchpad[1] = (raw >> 8) & 0xFF;
+    _scratchpad[8] = OneWire::crc8(_scratchpad, 8);
+
+    _conversionDone = 0;
+    _conversions++;
+}
+
+void DS18B20Sim::receiveByte(uint8_t v, uint64_t now)
+{
+    switch (_state) {
+        case ROM_CMD:
+            _bit = 0;
+            if (v == 0x55) _state = MATCH_ROM;
+            else if (v == 0xCC) _state = FUNCTION_CMD;
+            else if (v == 0xF0 || (v == 0xEC && _alarm)) { _state = SEARCH; _searchPhase = 0; }
+            else _state = IDLE;
+            break;
+
+        case FUNCTION_CMD:
+            _bit = 0;
+            if (v == 0x44) {
+                // 93.75 ms at 9 bit, doubling per bit. The DS18S20 always takes 750 ms.
+                uint8_t bits = isDS18S20() ? 12 : resolution();
+                _conversionDone = now + (750000UL >> (12 - bits));
+                _state = CONVERTING;
+            }
+            else if (v == 0xBE) {
+                memcpy(_txBuffer, _scratchpad, 9);
+                if (crcErrorRate > 0 && rand() < crcErrorRate * RAND_MAX) {
+                    int b = rand() % 72;
+                    _txBuffer[b >> 3] ^= 1 << (b & 7);
+                }
+                _state = READ_SCRATCHPAD;
+            }
+            else if (v == 0x4E) {
+                _state = WRITE_SCRATCHPAD;
+            }
+            else if (v == 0x48) {
+                memcpy(_eeprom, &_scratchpad[2], 3);    // Copy Scratchpad (the 10 ms write is not simulated)
+                _eepromWrites++;
+                _state = IDLE;
+            }
+            else {
+                _state = IDLE;    // Recall EEPROM, Read Power Supply: not simulated
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void DS18B20Sim::writeBit(uint8_t v, uint64_t now)
+{
+    finishConversion(now);
+
+    switch (_state) {
+        case ROM_CMD:
+        case FUNCTION_CMD:
+        case WRITE_SCRATCHPAD:
+            if ((_bit & 7) == 0) _byte = 0;
+            _byte |= (v & 1) << (_bit & 7);
+            _bit++;
+            if ((_bit & 7) == 0) {
+                if (_state == WRITE_SCRATCHPAD && _bit <= 24) {
+                    if (_bit < 24 || !isDS18S20()) _scratchpad[1 + _bit / 8] = _byte;
+                    if (_bit == 24) _scratchpad[4] = (_byte & 0x60) | 0x1F;
+                    _scratchpad[8] = OneWire::crc8(_scratchpad, 8);
+                    if (_bit == (isDS18S20() ? 16 : 24)) _state = IDLE;
+                }
+                else if (_state != WRITE_SCRATCHPAD) {
+                    receiveByte(_byte, now);
+                }
+            }
+            break;
+
+        case MATCH_ROM:
+            if ((v & 1) != romBit(_bit)) { _state = IDLE; break; }
+            if (++_bit == 64) { _state = FUNCTION_CMD; _bit = 0; }
+            break;
+
+        case SEARCH:
+            if (_searchPhase != 2) break;
+            if ((v & 1) != romBit(_bit)) { _state = IDLE; break; }    // search went the other way
+            _searchPhase = 0;
+            if (++_bit == 64) { _state = FUNCTION_CMD; _bit = 0; }
+            break;
+
+        default:
+            break;
+    }
+}
+
+uint8_t DS18B20Sim::readBit(uint64_t now)
+{
+    uint8_t r = 1;
+
+    finishConversion(now);
+
+    switch (_state) {
+        case SEARCH:
+            if (_searchPhase == 0) { r = romBit(_bit); _searchPhase = 1; }
+            else if (_searchPhase == 1) { r = !romBit(_bit); _searchPhase = 2; }
+            break;
+
+        case READ_SCRATCHPAD:
+            if (_bit < 72) r = (_txBuffer[_bit >> 3] >> (_bit & 7)) & 1;
+            _bit++;
+            break;
+
+        case CONVERTING:
+            r = _conversionDone ? 0 : 1;    // read slots return 0 while busy
+            break;
+
+        default:
+            break;
+    }
+
+    return r;
+}
+
+OneWireSim::OneWireSim(void) : OneWire(), shorted(false), resets(0), slots(0), busMicros(0), _count(0)
+{
+}
+
+uint8_t OneWireSim::attach(DS18B20Sim *device)
+{
+    if (_count >= ONEWIRE_SIM_MAX_DEVICES) return 0;
+
+    _devices[_count++] = device;
+
+    return 1;
+}
+
+uint8_t OneWireSim::reset(void)
+{
+    uint8_t presence = 0;
+
+    resets++;
+    busMicros += ONEWIRE_SIM_RESET_US;
+    sim_advance_us(ONEWIRE_SIM_RESET_US);
+
+    if (shorted) {
+        countReset(0, true);
+        return 0;
+    }
+
+    for (uint8_t i = 0; i < _count; i++) {
+        if (!_devices[i]->present) continue;
+        _devices[i]->busReset(sim_micros);
+        presence = 1;
+    }
+
+    // Bus health counters as the GPIO backend would count them
+    countIrqOff(70);
+    countReset(presence, false);
+
+    return presence;
+}
+
+void OneWireSim::write_bit(uint8_t v)
+{
+    slots++;
+    busMicros += ONEWIRE_SIM_SLOT_US;
+    sim_advance_us(ONEWIRE_SIM_SLOT_US);
+    countIrqOff((v & 1) ? 10 : 65);
+
+    if (shorted) return;
+
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_devices[i]->present) _devices[i]->writeBit(v, sim_micros);
+    }
+}
+
+uint8_t OneWireSim::read_bit(void)
+{
+    uint8_t r = 1;    // pull-up: 1 unless a device pulls the line low (wired AND)
+
+    slots++;
+    busMicros += ONEWIRE_SIM_SLOT_US;
+    sim_advance_us(ONEWIRE_SIM_SLOT_US);
+    countIrqOff(13);
+
+    if (shorted) return 0;
+
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_devices[i]->present) r &= _devices[i]->readBit(sim_micros);
+    }
+
+    return r;
+}
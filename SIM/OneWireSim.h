@@ -0,0 +1,106 @@
+#ifndef OneWireSim_h
+#define OneWireSim_h
+
+#include <inttypes.h>
+#include "application.h"
+#include "OneWire.h"
+
+// Virtual 1-Wire bus with simulated DS18B20 / DS18S20 sensors, for running
+// OneWire, TBus and the getTemperatures() code of the sketches on a PC.
+//
+// The simulation works per timeslot, like the real bus: OneWireSim replaces
+// only reset(), write_bit() and read_bit() of OneWire, so select(), search(),
+// the byte functions and everything built on them run unchanged. Every slot
+// advances the simulated clock (see application.h) by its real duration.
+
+#ifndef ONEWIRE_SIM_MAX_DEVICES
+#define ONEWIRE_SIM_MAX_DEVICES 32
+#endif
+
+// Real durations of the bus operations (µs), as bit-banged by OneWire.
+#define ONEWIRE_SIM_RESET_US 960
+#define ONEWIRE_SIM_SLOT_US  70
+
+class DS18B20Sim
+{
+  public:
+    // 'rom' is the 64 bit ROM ID. Its CRC byte (rom[7]) is recomputed.
+    DS18B20Sim(const uint8_t rom[8], double celsius = 20.0);
+
+    const uint8_t *rom(void) const { return _rom; }
+
+    // Temperature the next conversion will measure.
+    double celsius;
+
+    // Fault injection:
+    // - crcErrorRate: chance (0..1) that a scratchpad read has a flipped bit
+    // - present: false = sensor disconnected (does not answer at all)
+    double crcErrorRate;
+    bool present;
+
+    // Bus side, called by OneWireSim for every reset and timeslot
+    void busReset(uint64_t now);
+    void writeBit(uint8_t v, uint64_t now);
+    uint8_t readBit(uint64_t now);
+
+    bool alarm(void) const { return _alarm; }
+    uint8_t resolution(void) const { return 9 + ((_scratchpad[4] >> 5) & 0x03); }
+    uint32_t conversions(void) const { return _conversions; }
+
+    // Power the sensor down and up again (ex: after a loose connector):
+    // 85 °C in the scratchpad, TH, TL and config reloaded from its EEPROM.
+    void powerCycle(void);
+    uint32_t eepromWrites(void) const { return _eepromWrites; }
+
+  private:
+    enum State { IDLE, ROM_CMD, MATCH_ROM, SEARCH, FUNCTION_CMD, READ_SCRATCHPAD, WRITE_SCRATCHPAD, CONVERTING };
+
+    // Power-up scratchpad: 85 °C, TH 75, TL 70, 12 bit
+    static const uint8_t powerUp[9];
+
+    uint8_t _rom[8];
+    uint8_t _scratchpad[9];
+    uint8_t _txBuffer[9];    // scratchpad as sent, with injected errors
+    uint8_t _eeprom[3];      // TH, TL, config: written by Copy Scratchpad (0x48)
+    uint32_t _eepromWrites;
+    State _state;
+    uint8_t _byte;
+    uint8_t _bit;            // bit counter inside the current command
+    uint8_t _searchPhase;    // 0 = id bit, 1 = complement, 2 = direction
+    uint64_t _conversionDone;    // 0 = no conversion running
+    uint32_t _conversions;
+    bool _alarm;
+
+    bool isDS18S20(void) const { return _rom[0] == 0x10; }
+    void receiveByte(uint8_t v, uint64_t now);
+    void finishConversion(uint64_t now);
+    uint8_t romBit(uint8_t n) const { return (_rom[n >> 3] >> (n & 7)) & 1; }
+};
+
+class OneWireSim : public OneWire
+{
+  public:
+    OneWireSim(void);
+
+    // Add a sensor to the bus. Returns 0 if the bus is full.
+    uint8_t attach(DS18B20Sim *device);
+
+    // Fault injection: the whole bus is held low (no presence, reads 0).
+    bool shorted;
+
+    uint8_t reset(void);
+    void write_bit(uint8_t v);
+    uint8_t read_bit(void);
+    void depower(void) {}
+
+    // Statistics of the simulated bus
+    uint32_t resets;
+    uint32_t slots;
+    uint64_t busMicros;    // time the bus was in use
+
+  private:
+    DS18B20Sim *_devices[ONEWIRE_SIM_MAX_DEVICES];
+    uint8_t _count;
+};
+
+#endif // OneWireSim_h
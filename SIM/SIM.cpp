@@ -0,0 +1,128 @@
+/*
+
+SIM - T-BUS on the PC: S-HVAC's 12 boiler sensors on a virtual 1-Wire bus.
+
+Runs the same code as the Photon: OneWire, TBus (TESTROOM) and the
+getTemperatures() of S-HVAC, with the loop() sequence
+"poll() ... getTemperatures(0)" (pipelined TBus).
+Faults are injected along the way (CRC errors, a sensor that drops off,
+a shorted bus, a replaced sensor, an 85 °C spike) and the publishes, the
+filtered readings and the T-BUS time of every cycle are printed.
+
+Usage: tbus-sim [minutes]   (simulated time, default 5)
+
+*/
+
+#include "application.h"
+#include "OneWireSim.h"
+#include "TBus.h"
+#include "SensorArray.h"
+
+// *D3 - T-BUS (12 temp sensors), as in S-HVAC
+byte addrs0[12][8] =
+{{0x28,0xDB,0xB5,0x03,0x00,0x00,0x80,0xBB},
+ {0x28,0x7C,0xF0,0x03,0x00,0x00,0x80,0x59},
+ {0x28,0x72,0xDB,0x03,0x00,0x00,0x80,0xC2},
+ {0x28,0xAA,0xFB,0x03,0x00,0x00,0x80,0x5F},
+ {0x28,0x49,0xDD,0x03,0x00,0x00,0x80,0x4B},
+ {0x28,0xC3,0xD6,0x03,0x00,0x00,0x80,0x1E},
+ {0x28,0x3A,0xBC,0x07,0x00,0x00,0x80,0x58},
+ {0x28,0x72,0x03,0x04,0x00,0x00,0x80,0x24},
+ {0x28,0xD4,0xE7,0x03,0x00,0x00,0x80,0x89},
+ {0x28,0x78,0xF9,0x03,0x00,0x00,0x80,0x76},
+ {0x28,0x70,0xAD,0x07,0x00,0x00,0x80,0x53},
+ {0x28,0x40,0xE1,0x03,0x00,0x00,0x80,0x78}};
+byte resolution0[12] = {10,10,10,10,10,10,10,10,10,10,10,10};
+
+SensorArray<12> boilers(addrs0);
+centi_t &KSTopH = boilers.filtered[0], &KSTopL = boilers.filtered[1], &KSMidH = boilers.filtered[2], &KSMidL = boilers.filtered[3], &KSBotH = boilers.filtered[4], &KSBotL = boilers.filtered[5];
+centi_t &KWTopH = boilers.filtered[6], &KWTopL = boilers.filtered[7], &KWMidH = boilers.filtered[8], &KWMidL = boilers.filtered[9], &KWBotH = boilers.filtered[10], &KWBotL = boilers.filtered[11];
+
+OneWireSim ds;
+TBus tbus(ds, boilers.rom, boilers.count);
+
+char crcErrorJSON[128];
+uint32_t getTemperaturesInterval = 10 * 1000;
+
+// getTemperatures() of S-HVAC itself, with the Alert publish switched on
+#define HVAC_SENSOR_ALERTS 1
+#include "getTemperatures.h"
+
+int main(int argc, char *argv[])
+{
+    int minutes = (argc > 1) ? atoi(argv[1]) : 5;
+    uint32_t cycles = 0;
+    uint64_t busStart = 0;
+    double spike = 0;
+    char json[400];
+
+    // KS boiler 60..35 °C top to bottom, KW boiler 50..30 °C
+    static DS18B20Sim *sensors[12];
+    for (int i = 0; i < 12; i++) {
+        sensors[i] = new DS18B20Sim(addrs0[i], (i < 6) ? 60 - 5 * i : 50 - 4 * (i - 6));
+        ds.attach(sensors[i]);
+    }
+    sensors[3]->crcErrorRate = 0.05;    // a bad cable on KSMidL
+
+    // Spare sensor, not in addrs0: replaces KSTopH halfway
+    const uint8_t spareRom[8] = {0x28,0x11,0x22,0x33,0x00,0x00,0x80,0x00};
+    DS18B20Sim spare(spareRom, 61);
+    spare.present = false;
+    ds.attach(&spare);
+
+    EEPROM.clear();
+    boilers.begin(Time.now());
+    boilers.setLimits(CENTI(1), CENTI(99));
+    tbus.bind(0);
+    tbus.setResolution(resolution0);
+    tbus.setAlarmPolling(1, 6);
+    tbus.setPipelined(getTemperaturesInterval);
+    printf("T-BUS: %d sensors, conversion %d ms\n", tbus.count(), tbus.conversionTime());
+
+    while (millis() < (uint32_t)minutes * 60000UL)
+    {
+        uint32_t m = millis();
+
+        // Faults on a time line
+        if (m >= 60000 && m < 70000) sensors[7]->present = false;     // KWTopL drops off for 10 s...
+        else if (!sensors[7]->present) {
+            sensors[7]->powerCycle();                                  // ...and comes back with the config of its EEPROM
+            sensors[7]->present = true;
+        }
+        ds.shorted = (m >= 90000 && m < 95000);                       // bus shorted for 5 s
+        if (m >= 120000 && sensors[0]->present) {                      // KSTopH replaced
+            sensors[0]->present = false;
+            spare.present = true;
+            tbus.scan();
+            tbus.romJSON(json, sizeof(json));
+            Particle.publish("OneWire", json, 60, PRIVATE);
+        }
+        for (int i = 0; i < 12; i++) sensors[i]->celsius += 0.0005;   // heating: 0.6 °C per minute
+        sensors[4]->celsius -= spike;                                  // KSBotH reads 85 °C (power-up value) for one cycle
+        spike = (m >= 150000 && m < 160000) ? 85.0 - sensors[4]->celsius : 0;
+        sensors[4]->celsius += spike;
+        spare.celsius += 0.0005;
+
+        if (tbus.poll())
+        {
+            getTemperatures(0);
+            cycles++;
+            printf("[%8.3f s] KS %.2f %.2f %.2f %.2f %.2f %.2f  KW %.2f %.2f %.2f %.2f %.2f %.2f  bus %llu us\n",
+                   sim_micros / 1e6, boilers.celsius(0), boilers.celsius(1), boilers.celsius(2), boilers.celsius(3), boilers.celsius(4), boilers.celsius(5),
+                   boilers.celsius(6), boilers.celsius(7), boilers.celsius(8), boilers.celsius(9), boilers.celsius(10), boilers.celsius(11),
+                   (unsigned long long)(ds.busMicros - busStart));
+            busStart = ds.busMicros;
+        }
+
+        delay(50);    // rest of loop()
+    }
+
+    printf("%u cycles, %u resets, %u slots, bus busy %.3f s of %.3f s\n",
+           cycles, ds.resets, ds.slots, ds.busMicros / 1e6, sim_micros / 1e6);
+    printf("KWTopL after its power cycle: %d bit, %u EEPROM writes\n", sensors[7]->resolution(), sensors[7]->eepromWrites());
+    printf("CRC_Errors: %s\n", crcErrorJSON);
+    tbus.statsJSON(json, sizeof(json));
+    printf("TBUS_health: %s\n", json);
+
+    return 0;
+}
@@ -0,0 +1,111 @@
+/*
+
+ScratchpadTest - OneWire::read_scratchpad_checked() on the virtual bus.
+
+A DS18S20 at -0.5 °C with its alarms at -1 °C sends FF FF FF FF FF as its
+first 5 bytes (temperature, TH, TL, the fixed 0xFF of byte 4): a valid
+reading that must not be taken for a missing sensor. A missing sensor or a
+shorted bus must still be given up on early: the bytes on the bus are
+counted, 5 for a DS18B20 and for a short, 8 for 0xFF on a DS18S20 (see
+OneWire::deadBusBytes()), followed by a reset. Also checks a CRC error and
+that the next read after each fault is OK again.
+
+Usage: scratchpad-test
+Exit code 0 = all OK.
+
+*/
+
+#include "application.h"
+#include "OneWireSim.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...) \
+    if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); failures++; }
+
+// Convert T + Read Scratchpad of 'rom' with the given family code for the
+// dead bus check. Returns the read_scratchpad_checked() result, the bytes
+// it read and the resets it did.
+static uint8_t readSensor(OneWireSim &ds, const uint8_t *rom, uint8_t family, uint8_t *data, uint32_t *bytes, uint32_t *resets)
+{
+    uint8_t result;
+    uint32_t b0, r0;
+
+    ds.reset();
+    ds.select(rom);
+    ds.write(0x44);
+    delay(750);
+
+    ds.reset();
+    ds.select(rom);
+    ds.write(0xBE);
+
+    b0 = ds.stats().bytes;
+    r0 = ds.resets;
+    result = ds.read_scratchpad_checked(data, 9, family);
+    *bytes = ds.stats().bytes - b0;
+    *resets = ds.resets - r0;
+
+    return result;
+}
+
+int main(void)
+{
+    OneWireSim ds;
+    const uint8_t rom10[8] = {0x10,0x5A,0x3C,0x11,0x02,0x08,0x00,0x00};
+    const uint8_t rom28[8] = {0x28,0xDB,0xB5,0x03,0x00,0x00,0x80,0x00};
+    DS18B20Sim s(rom10, -0.5), b(rom28, 21.0);
+    uint8_t data[9];
+    uint8_t result;
+    uint32_t bytes, resets;
+
+    ds.attach(&s);
+    ds.attach(&b);
+
+    // TH = TL = -1 °C
+    ds.reset();
+    ds.select(s.rom());
+    ds.write(0x4E);
+    ds.write(0xFF);
+    ds.write(0xFF);
+
+    result = readSensor(ds, s.rom(), 0x10, data, &bytes, &resets);
+    CHECK(result == ONEWIRE_READ_OK && bytes == 9, "DS18S20 at -0.5 °C: result %d, %u bytes", result, bytes);
+    CHECK(data[0] == 0xFF && data[1] == 0xFF && data[2] == 0xFF && data[3] == 0xFF && data[4] == 0xFF,
+          "first 5 bytes %02X %02X %02X %02X %02X", data[0], data[1], data[2], data[3], data[4]);
+
+    result = readSensor(ds, s.rom(), 0, data, &bytes, &resets);
+    CHECK(result == ONEWIRE_READ_OK && bytes == 9, "DS18S20 at -0.5 °C, family unknown: result %d, %u bytes", result, bytes);
+
+    result = readSensor(ds, b.rom(), 0x28, data, &bytes, &resets);
+    CHECK(result == ONEWIRE_READ_OK && bytes == 9 && resets == 0, "DS18B20: result %d, %u bytes, %u resets", result, bytes, resets);
+
+    s.present = false;
+    result = readSensor(ds, s.rom(), 0x10, data, &bytes, &resets);
+    CHECK(result == ONEWIRE_READ_ABSENT && bytes == 8 && resets == 1, "missing DS18S20: result %d, %u bytes, %u resets", result, bytes, resets);
+    s.present = true;
+
+    b.present = false;
+    result = readSensor(ds, b.rom(), 0x28, data, &bytes, &resets);
+    CHECK(result == ONEWIRE_READ_ABSENT && bytes == 5 && resets == 1, "missing DS18B20: result %d, %u bytes, %u resets", result, bytes, resets);
+    b.present = true;
+
+    ds.shorted = true;
+    result = readSensor(ds, s.rom(), 0x10, data, &bytes, &resets);
+    CHECK(result == ONEWIRE_READ_SHORTED && bytes == 5 && resets == 1, "shorted bus: result %d, %u bytes, %u resets", result, bytes, resets);
+    ds.shorted = false;
+
+    s.crcErrorRate = 1;
+    result = readSensor(ds, s.rom(), 0x10, data, &bytes, &resets);
+    CHECK(result == ONEWIRE_READ_CRC_ERROR && bytes == 9 && resets == 1, "bad cable: result %d, %u bytes, %u resets", result, bytes, resets);
+    s.crcErrorRate = 0;
+
+    result = readSensor(ds, s.rom(), 0x10, data, &bytes, &resets);
+    CHECK(result == ONEWIRE_READ_OK, "DS18S20 after the faults: result %d", result);
+    result = readSensor(ds, b.rom(), 0x28, data, &bytes, &resets);
+    CHECK(result == ONEWIRE_READ_OK, "DS18B20 after the faults: result %d", result);
+
+    printf(failures ? "%d FAILURES\n" : "ALL OK\n", failures);
+
+    return failures ? 1 : 0;
+}
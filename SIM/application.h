@@ -0,0 +1,118 @@
+// application.h = Host (Linux) stand-in for the Particle firmware header.
+//
+// Only what the T-BUS code needs: OneWire, TBus and the getTemperatures() bookkeeping of the sketches
+// (Time.now(), Particle.publish(), String...). Time is simulated: millis()/micros() only move when the
+// bus is used or delay() is called, so a run of hours takes milliseconds and the T-BUS time can be measured.
+//
+// Build: see Readme.md
+
+#ifndef application_h
+#define application_h
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+
+#define PLATFORM_ID 3 // Particle "gcc" platform: OneWire uses the generic pin functions below
+
+typedef uint16_t pin_t;
+typedef uint8_t byte;
+
+#define INPUT 0
+#define OUTPUT 1
+#define OUTPUT_OPEN_DRAIN 2
+#define LOW 0
+#define HIGH 1
+#define FALSE 0
+#define TRUE 1
+#define PRIVATE 1
+#define D3 3
+
+// Simulated clock (µs since start). Advanced by delay() and by the virtual 1-Wire bus.
+extern uint64_t sim_micros;
+inline void sim_advance_us(uint32_t us) { sim_micros += us; }
+
+inline uint32_t micros(void) { return (uint32_t)sim_micros; }
+inline uint32_t millis(void) { return (uint32_t)(sim_micros / 1000); }
+inline void delay(uint32_t ms) { sim_advance_us(ms * 1000); }
+inline void delayMicroseconds(uint32_t us) { sim_advance_us(us); }
+
+// Interrupt masking: counted, so the time spent with interrupts off can be reported
+extern uint32_t sim_irq_off;
+inline void noInterrupts(void) { sim_irq_off++; }
+inline void interrupts(void) {}
+
+// GPIO: the virtual bus replaces the bit-banging, so these do nothing
+inline void pinMode(uint16_t, int) {}
+inline void HAL_Pin_Mode(uint16_t, int) {}
+inline void pinResetFast(uint16_t) {}
+inline void pinSetFast(uint16_t) {}
+inline int32_t pinReadFast(uint16_t) { return HIGH; }
+inline void digitalWrite(uint16_t, uint8_t) {}
+inline int32_t digitalRead(uint16_t) { return HIGH; }
+
+// EEPROM (2047 bytes like the Photon)
+class EEPROMClass
+{
+  public:
+    uint8_t read(int a) const { return (a >= 0 && a < (int)sizeof(_mem)) ? _mem[a] : 0xFF; }
+    void write(int a, uint8_t v) { if (a >= 0 && a < (int)sizeof(_mem)) _mem[a] = v; }
+    void clear(void) { memset(_mem, 0xFF, sizeof(_mem)); }
+    EEPROMClass() { clear(); }
+  private:
+    uint8_t _mem[2047];
+};
+extern EEPROMClass EEPROM;
+
+// UART (only so OneWireUART.h compiles)
+class USARTSerial
+{
+  public:
+    void begin(uint32_t) {}
+    void end(void) {}
+    void halfduplex(bool) {}
+    int available(void) { return 0; }
+    int read(void) { return -1; }
+    size_t write(uint8_t) { return 1; }
+    size_t write(const uint8_t *, size_t n) { return n; }
+};
+
+// Minimal Arduino String: enough for message + String(i)
+class String
+{
+  public:
+    String(void) {}
+    String(const char *s) : _s(s ? s : "") {}
+    String(int v) : _s(std::to_string(v)) {}
+    String operator+(const String &o) const { String r; r._s = _s + o._s; return r; }
+    bool operator==(const char *s) const { return _s == s; }
+    const char *c_str(void) const { return _s.c_str(); }
+  private:
+    std::string _s;
+};
+
+class TimeClass
+{
+  public:
+    uint32_t now(void) const { return 1600000000UL + (uint32_t)(sim_micros / 1000000); }
+};
+extern TimeClass Time;
+
+// Publishes are printed on stdout
+class ParticleClass
+{
+  public:
+    bool publish(const char *name, const char *data, int = 60, int = PRIVATE) { printf("[%8.3f s] %s: %s\n", sim_micros / 1e6, name, data); return true; }
+    bool publish(const char *name, const String &data, int ttl = 60, int flags = PRIVATE) { return publish(name, data.c_str(), ttl, flags); }
+    bool publish(const String &name, const String &data, int ttl = 60, int flags = PRIVATE) { return publish(name.c_str(), data.c_str(), ttl, flags); }
+    bool connected(void) const { return true; }
+};
+extern ParticleClass Particle;
+
+inline char *itoa(int v, char *buf, int) { sprintf(buf, "%d", v); return buf; }
+
+#endif // application_h
@@ -90,6 +90,8 @@ static uint8_t buffer[SSD1306_LCDHEIGHT * SSD1306_LCDWIDTH / 8] = {
 #endif
 };
 
+// what the panel shows: display() only sends the bytes that differ from it
+static uint8_t shown[SSD1306_LCDHEIGHT * SSD1306_LCDWIDTH / 8];
 
 
 // the most basic function, set a single pixel
@@ -114,10 +116,29 @@ void Adafruit_SSD1306::drawPixel(int16_t x, int16_t y, uint16_t color) {
   }  
 
   // x is which column
+  uint8_t *pBuf = &buffer[x+ (y/8)*SSD1306_LCDWIDTH];
+  uint8_t old = *pBuf;
   if (color == WHITE) 
-    buffer[x+ (y/8)*SSD1306_LCDWIDTH] |= (1 << (y&7));  
+    *pBuf |= (1 << (y&7));  
   else
-    buffer[x+ (y/8)*SSD1306_LCDWIDTH] &= ~(1 << (y&7)); 
+    *pBuf &= ~(1 << (y&7)); 
+  if (*pBuf != old)
+    markDirty(y/8, x, x);
+}
+
+// columns first..last of page have changed since the last display()
+void Adafruit_SSD1306::markDirty(uint8_t page, uint8_t first, uint8_t last) {
+  if (first < _dirtyFirst[page]) _dirtyFirst[page] = first;
+  if (last > _dirtyLast[page]) _dirtyLast[page] = last;
+}
+
+// the panel content is unknown (reset, scrolling): send the whole buffer
+void Adafruit_SSD1306::markAllDirty(void) {
+  for (uint8_t page = 0; page < SSD1306_PAGES; page++) {
+    _dirtyFirst[page] = 0;
+    _dirtyLast[page] = SSD1306_LCDWIDTH - 1;
+  }
+  _shownValid = false;
 }
 
 // constructor for software SPI - we indicate DataCommand, ChipSelect, Reset 
@@ -128,6 +149,7 @@ Adafruit_SSD1306::Adafruit_SSD1306(int8_t SID, int8_t SCLK, int8_t DC, int8_t RS
   sclk = SCLK;
   sid = SID;
   hwSPI = false;
+  markAllDirty();
 }
 
 // constructor for hardware SPI - we indicate DataCommand, ChipSelect, Reset 
@@ -136,6 +158,7 @@ Adafruit_SSD1306::Adafruit_SSD1306(int8_t DC, int8_t RST, int8_t CS) : Adafruit_
   rst = RST;
   cs = CS;
   hwSPI = true;
+  markAllDirty();
 }
 
 // initializer for I2C - we only indicate the reset pin!
@@ -143,6 +166,7 @@ Adafruit_SSD1306::Adafruit_SSD1306(int8_t reset) :
 Adafruit_GFX(SSD1306_LCDWIDTH, SSD1306_LCDHEIGHT) {
   sclk = dc = cs = sid = -1;
   rst = reset;
+  markAllDirty();
 }
   
 
@@ -258,6 +282,7 @@ void Adafruit_SSD1306::begin(uint8_t vccstate, uint8_t i2caddr) {
   #endif
   
   ssd1306_command(SSD1306_DISPLAYON);//--turn on oled panel
+  markAllDirty(); // the reset cleared the panel RAM
 }
 
 
@@ -356,6 +381,7 @@ void Adafruit_SSD1306::startscrolldiagleft(uint8_t start, uint8_t stop){
 
 void Adafruit_SSD1306::stopscroll(void){
 	ssd1306_command(SSD1306_DEACTIVATE_SCROLL);
+	markAllDirty(); // the scroll moved the panel RAM: rewrite it
 }
 
 // Dim the display
@@ -400,15 +426,41 @@ void Adafruit_SSD1306::ssd1306_data(uint8_t c) {
   }
 }
 
+// Send the changed part of each page: a window of columns first..last
+// (COLUMNADDR) on that page (PAGEADDR), then its bytes.
 void Adafruit_SSD1306::display(void) {
-  ssd1306_command(SSD1306_COLUMNADDR);
-  ssd1306_command(0);   // Column start address (0 = reset)
-  ssd1306_command(127); // Column end address (127 = reset)
+  for (uint8_t page = 0; page < SSD1306_PAGES; page++) {
+    uint8_t first = _dirtyFirst[page];
+    uint8_t last = _dirtyLast[page];
+    const uint8_t *row = buffer + page * SSD1306_LCDWIDTH;
+    uint8_t *seen = shown + page * SSD1306_LCDWIDTH;
+
+    if (first > last) continue; // nothing drawn on this page
+    _dirtyFirst[page] = 0xFF;
+    _dirtyLast[page] = 0;
+
+    if (_shownValid) {
+      // drawn, but maybe the same as before (clearDisplay() + redraw)
+      while (first <= last && row[first] == seen[first]) first++;
+      if (first > last) continue;
+      while (row[last] == seen[last]) last--;
+    }
+    memcpy(seen + first, row + first, last - first + 1);
+
+    ssd1306_command(SSD1306_COLUMNADDR);
+    ssd1306_command(first); // Column start address
+    ssd1306_command(last);  // Column end address
 
-  ssd1306_command(SSD1306_PAGEADDR);
-  ssd1306_command(0); // Page start address (0 = reset)
-  ssd1306_command((SSD1306_LCDHEIGHT == 64) ? 7 : 3); // Page end address
+    ssd1306_command(SSD1306_PAGEADDR);
+    ssd1306_command(page); // Page start address
+    ssd1306_command(page); // Page end address
 
+    sendData(row + first, last - first + 1);
+  }
+  _shownValid = true;
+}
+
+void Adafruit_SSD1306::sendData(const uint8_t *data, uint16_t n) {
   if (sid != -1)
   {
     // SPI
@@ -417,9 +469,8 @@ void Adafruit_SSD1306::display(void) {
     digitalWrite(cs, LOW);
 	delayMicroseconds(1);		// May not be necessary - needs testing
 
-    for (uint16_t i=0; i<(SSD1306_LCDWIDTH*SSD1306_LCDHEIGHT/8); i++) {
-      fastSPIwrite(buffer[i]);
-      //ssd1306_data(buffer[i]);
+    for (uint16_t i=0; i<n; i++) {
+      fastSPIwrite(data[i]);
     }
 	delayMicroseconds(1);		// May not be necessary - needs testing
     digitalWrite(cs, HIGH);
@@ -427,15 +478,13 @@ void Adafruit_SSD1306::display(void) {
   else
   {
     // I2C
-    for (uint16_t i=0; i<(SSD1306_LCDWIDTH*SSD1306_LCDHEIGHT/8); i++) {
+    for (uint16_t i=0; i<n; i+=16) {
       // send a bunch of data in one xmission
       Wire.beginTransmission(_i2caddr);
       Wire.write(0x40);
-      for (uint8_t x=0; x<16; x++) {
-		Wire.write(buffer[i]);
-		i++;
+      for (uint16_t k=i; k<n && k<i+16; k++) {
+		Wire.write(data[k]);
 		}
-	i--;
 	Wire.endTransmission();
 	}
   }
@@ -444,6 +493,9 @@ void Adafruit_SSD1306::display(void) {
 // clear everything
 void Adafruit_SSD1306::clearDisplay(void) {
   memset(buffer, 0, (SSD1306_LCDWIDTH*SSD1306_LCDHEIGHT/8));
+  for (uint8_t page = 0; page < SSD1306_PAGES; page++) {
+    markDirty(page, 0, SSD1306_LCDWIDTH - 1);
+  }
 }
 
 
@@ -502,7 +554,7 @@ void Adafruit_SSD1306::drawFastHLineInternal(int16_t x, int16_t y, int16_t w, ui
 
   // make sure we don't go off the edge of the display
   if( (x + w) > WIDTH) { 
-    w = (HEIGHT- x);
+    w = (WIDTH - x);
   }
 
   // if our width is now negative, punt
@@ -517,6 +569,8 @@ void Adafruit_SSD1306::drawFastHLineInternal(int16_t x, int16_t y, int16_t w, ui
 
   register uint8_t mask = 1 << (y&7);
 
+  markDirty(y/8, x, x + w - 1);
+
   if(color == WHITE) { 
     while(w--) { *pBuf++ |= mask; }
   } else {
@@ -582,6 +636,10 @@ void Adafruit_SSD1306::drawFastVLineInternal(int16_t x, int16_t __y, int16_t __h
     return;
   }
 
+  for (uint8_t page = __y/8; page <= (__y + __h - 1)/8; page++) {
+    markDirty(page, x, x);
+  }
+
   // this display doesn't need ints for coordinates, use local byte registers for faster juggling
   register uint8_t y = __y;
   register uint8_t h = __h;
@@ -109,6 +109,15 @@ All text above, and the splash screen must be included in any redistribution
 #define SSD1306_VERTICAL_AND_RIGHT_HORIZONTAL_SCROLL 0x29
 #define SSD1306_VERTICAL_AND_LEFT_HORIZONTAL_SCROLL 0x2A
 
+// display() only sends what changed. The draw functions mark, per page (8
+// rows), the columns they touched; display() compares those with a copy of
+// what the panel shows and sends, per page, only the columns from the first
+// to the last one that differ (COLUMNADDR/PAGEADDR window). A clearDisplay()
+// and a redraw of the same screen with one new value sends that value: about
+// 50 bytes on I2C instead of 1 KB.
+// begin() and stopscroll() make the next display() send everything.
+#define SSD1306_PAGES (SSD1306_LCDHEIGHT / 8)
+
 class Adafruit_SSD1306 : public Adafruit_GFX {
  public:
   Adafruit_SSD1306(int8_t SID, int8_t SCLK, int8_t DC, int8_t RST, int8_t CS);
@@ -143,6 +152,12 @@ class Adafruit_SSD1306 : public Adafruit_GFX {
 
   boolean hwSPI;
 
+  uint8_t _dirtyFirst[SSD1306_PAGES], _dirtyLast[SSD1306_PAGES]; // changed columns per page (first > last = none)
+  boolean _shownValid; // false: the panel content is unknown, send all
+  void markDirty(uint8_t page, uint8_t first, uint8_t last);
+  void markAllDirty(void);
+  void sendData(const uint8_t *data, uint16_t n);
+
   inline void drawFastVLineInternal(int16_t x, int16_t y, int16_t h, uint16_t color) __attribute__((always_inline));
   inline void drawFastHLineInternal(int16_t x, int16_t y, int16_t w, uint16_t color) __attribute__((always_inline));
 
@@ -0,0 +1,200 @@
+/*
+
+Fader - Non-blocking fades of PowerPixel channels and PWM dimmers (see Fader.h).
+
+Replaces the delay() loops of DimUp(), DimDown(), DimUpGroups(),
+DimDownGroups() and the A7 dimmer of MOV2Lightson(): every fade is a line
+from (start, from) to (start + ms, to), update() writes the point of 'now'.
+
+*/
+
+#include "Fader.h"
+#include "application.h"
+
+Fader::Fader(Adafruit_NeoPixel &strip)
+    : _strip(strip), _show(false)
+{
+    for (uint8_t i = 0; i < FADER_MAX_FADES; i++) {
+        _fades[i].target = 0;
+        _fades[i].channel = FADER_NONE;
+        _fades[i].running = false;
+    }
+}
+
+bool Fader::fadeChannel(uint16_t n, uint8_t c, uint8_t from, uint8_t to, uint32_t ms, uint32_t after)
+{
+    Fade *f;
+    uint16_t from16 = from * 257;    // 255 -> 65535
+
+    if (c > FADER_PWM) return false;
+    if (c != FADER_PWM && n >= _strip.numPixels()) return false;
+
+    f = find(n, c);
+    if (f && f->running) from16 = f->value;    // still fading: go on from where it is
+    if (!f) f = slot();
+
+    if (!f) {
+        Fade now = { n, c, (uint16_t)(to * 257), (uint16_t)(to * 257), (uint16_t)(to * 257), false, 0, 0 };
+
+        write(now);
+        return false;
+    }
+
+    f->target = n;
+    f->channel = c;
+    f->from = from16;
+    f->to = to * 257;
+    f->value = from16;
+    f->running = true;
+    f->start = millis() + after;
+    f->ms = ms > FADER_MAX_MS ? FADER_MAX_MS : ms;
+    write(*f);
+
+    return true;
+}
+
+bool Fader::fade(uint16_t n, uint32_t from, uint32_t to, uint32_t ms, uint32_t after)
+{
+    bool ok = true;
+
+    for (uint8_t c = FADER_RED; c <= FADER_BLUE; c++) {
+        uint8_t shift = 16 - 8 * c;    // Color() = 0x00RRGGBB
+
+        if (!fadeChannel(n, c, (uint8_t)(from >> shift), (uint8_t)(to >> shift), ms, after)) ok = false;
+    }
+
+    return ok;
+}
+
+bool Fader::fadeTo(uint16_t n, uint32_t to, uint32_t ms, uint32_t after)
+{
+    return fade(n, _strip.getPixelColor(n), to, ms, after);
+}
+
+bool Fader::fadePWM(uint16_t pin, uint8_t from, uint8_t to, uint32_t ms, uint32_t after)
+{
+    return fadeChannel(pin, FADER_PWM, from, to, ms, after);
+}
+
+void Fader::stop(uint16_t n)
+{
+    for (uint8_t i = 0; i < FADER_MAX_FADES; i++) {
+        if (_fades[i].target == n && _fades[i].channel <= FADER_BLUE) _fades[i].running = false;
+    }
+}
+
+uint8_t Fader::level(uint16_t n, uint8_t c, uint8_t otherwise) const
+{
+    for (uint8_t i = 0; i < FADER_MAX_FADES; i++) {
+        if (_fades[i].target == n && _fades[i].channel == c) return _fades[i].value >> 8;
+    }
+
+    if (c > FADER_BLUE || n >= _strip.numPixels()) return otherwise;    // FADER_PWM
+
+    return _strip.getPixelColor(n) >> (16 - 8 * c);
+}
+
+bool Fader::busy(void) const
+{
+    for (uint8_t i = 0; i < FADER_MAX_FADES; i++) {
+        if (_fades[i].running) return true;
+    }
+
+    return false;
+}
+
+bool Fader::busy(uint16_t n) const
+{
+    for (uint8_t i = 0; i < FADER_MAX_FADES; i++) {
+        if (_fades[i].running && _fades[i].target == n && _fades[i].channel <= FADER_BLUE) return true;
+    }
+
+    return false;
+}
+
+bool Fader::update(uint32_t now)
+{
+    bool running = false;
+
+    for (uint8_t i = 0; i < FADER_MAX_FADES; i++) {
+        Fade &f = _fades[i];
+        int32_t t;
+        uint16_t v;
+
+        if (!f.running) continue;
+
+        t = (int32_t)(now - f.start);    // < 0: still waiting
+        if (t < 0) {
+            v = f.from;
+        } else if ((uint32_t)t >= f.ms) {
+            v = f.to;
+            f.running = false;
+        } else {
+            v = f.from + (int32_t)((int64_t)((int32_t)f.to - f.from) * t / f.ms);
+        }
+
+        // 8 bit outputs only change every 257; a dithering strip takes all 16 bits
+        if (v != f.value) {
+            bool step = (v >> 8) != (f.value >> 8);
+
+            f.value = v;
+            if (step || (f.channel != FADER_PWM && _strip.isDithering())) write(f);
+        }
+        if (f.running) running = true;
+    }
+
+    if (_show) {
+        _strip.show();
+        _show = false;
+    }
+
+    return running;
+}
+
+Fader::Fade *Fader::find(uint16_t target, uint8_t channel)
+{
+    for (uint8_t i = 0; i < FADER_MAX_FADES; i++) {
+        if (_fades[i].target == target && _fades[i].channel == channel) return &_fades[i];
+    }
+
+    return 0;
+}
+
+// A free slot, else the first finished one (its output keeps its value)
+Fader::Fade *Fader::slot(void)
+{
+    Fade *done = 0;
+
+    for (uint8_t i = 0; i < FADER_MAX_FADES; i++) {
+        if (_fades[i].channel == FADER_NONE) return &_fades[i];
+        if (!done && !_fades[i].running) done = &_fades[i];
+    }
+
+    return done;
+}
+
+void Fader::write(const Fade &f)
+{
+    uint32_t color;
+    uint8_t shift;
+
+    if (f.channel == FADER_PWM) {
+        analogWrite(f.target, f.value >> 8);
+        return;
+    }
+
+    if (_strip.isDithering()) {
+        uint16_t rgb[3];
+
+        _strip.getPixelColor16(f.target, &rgb[0], &rgb[1], &rgb[2]);
+        rgb[f.channel] = f.value;
+        _strip.setPixelColor16(f.target, rgb[0], rgb[1], rgb[2]);
+        return;    // refresh() sends it
+    }
+
+    shift = 16 - 8 * f.channel;
+    color = _strip.getPixelColor(f.target);
+    color = (color & ~((uint32_t)0xFF << shift)) | ((uint32_t)(f.value >> 8) << shift);
+    _strip.setPixelColor(f.target, color);
+    _show = true;
+}
@@ -0,0 +1,108 @@
+#ifndef Fader_h
+#define Fader_h
+
+#include <inttypes.h>
+#include "application.h"
+#include "neopixel.h"
+
+// Maximum number of fading outputs (one pixel channel or one PWM pin each).
+// 5 PowerPixels fading R, G and B at once take 15.
+#ifndef FADER_MAX_FADES
+#define FADER_MAX_FADES 16
+#endif
+
+// Longest fade (ms). Longer ones are cut to this.
+#define FADER_MAX_MS 0x7FFFFF    // 2h19
+
+// Output of a fade: a channel of a pixel or a PWM pin (analogWrite())
+#define FADER_RED   0
+#define FADER_GREEN 1
+#define FADER_BLUE  2
+#define FADER_PWM   3
+#define FADER_NONE  0xFF
+
+// Non-blocking fades of PowerPixel channels and PWM dimmers.
+//
+// The old DimUp()/DimDown() loops did setPixelColor() + show() + delay(wait)
+// 255 times: loop() stood still for 255 * wait ms (3 * 255 * wait for the
+// group fades), no PIR, keypad or publish in between. Here a fade is only a
+// start value, target, start time and duration per output. update() runs
+// from loop() and sets every output to where it should be at that moment,
+// so the fades go on while loop() does its other work. The steps follow
+// millis(), not the number of loop() passes: a slow pass gives a bigger step,
+// not a longer fade.
+//
+//    Fader fader(strip);
+//    fader.fade(0, strip.Color(0,0,0), strip.Color(255,255,255), 1275);  // = DimUp(0, 0, 255, 5)
+//    fader.fadeChannel(0, FADER_GREEN, 0, 255, 1275, 1275);             // G after R (group fade)
+//    fader.fadePWM(A7, 255, 0, 6000);                                   // A7 dimmer
+//
+//    loop() { fader.update(); strip.flush(); ... }
+//
+// A new fade of an output that is still fading starts where that one is now
+// ('from' is then ignored): a light switched off halfway its fade-in fades
+// out from there, without a flash. A waiting fade ('after') holds 'from'.
+//
+// update() calls strip.show() at most once per pass, and only if a pixel
+// changed (see setDeferred() of the strip to merge it with other shows).
+// The fades run in 16 bits: on a dithering strip (setDither()) a slow fade
+// at the low end moves in 256 small steps per 8 bit level.
+// Set a pixel directly only after stop(), or the fade overwrites it.
+class Fader
+{
+  public:
+    Fader(Adafruit_NeoPixel &strip);
+
+    // Fade channel 'c' (FADER_RED, _GREEN, _BLUE) of pixel 'n' from 'from'
+    // to 'to' in 'ms', starting 'after' ms from now. Returns false if all
+    // FADER_MAX_FADES are busy: the channel is then set to 'to' at once.
+    bool fadeChannel(uint16_t n, uint8_t c, uint8_t from, uint8_t to, uint32_t ms, uint32_t after = 0);
+
+    // Fade all channels of pixel 'n' (colors from Adafruit_NeoPixel::Color()).
+    bool fade(uint16_t n, uint32_t from, uint32_t to, uint32_t ms, uint32_t after = 0);
+
+    // Fade pixel 'n' from its present color to 'to'.
+    bool fadeTo(uint16_t n, uint32_t to, uint32_t ms, uint32_t after = 0);
+
+    // Fade the PWM output (analogWrite(), 0..255) of 'pin'.
+    bool fadePWM(uint16_t pin, uint8_t from, uint8_t to, uint32_t ms, uint32_t after = 0);
+
+    // Stop the fades of pixel 'n': its channels stay where they are.
+    void stop(uint16_t n);
+
+    // Present level (0..255) of channel 'c' of pixel 'n', or of PWM pin 'n'
+    // (c = FADER_PWM): where the last update() left it, also halfway a fade.
+    // A pixel without a fade: its color in the strip. A pin the fader does
+    // not know (analogWrite() cannot be read back): 'otherwise'.
+    uint8_t level(uint16_t n, uint8_t c, uint8_t otherwise = 0) const;
+
+    // A fade is running or waiting (all outputs, or pixel 'n').
+    bool busy(void) const;
+    bool busy(uint16_t n) const;
+
+    // Advance all fades to 'now' (every loop() pass). Returns busy().
+    bool update(uint32_t now);
+    bool update(void) { return update(millis()); }
+
+  private:
+    struct Fade
+    {
+        uint16_t target;     // pixel number or pin
+        uint8_t channel;     // FADER_RED..FADER_PWM, FADER_NONE = free slot
+        uint16_t from, to;   // 16 bit: 255 = 65535
+        uint16_t value;      // present value of the output
+        bool running;
+        uint32_t start;      // millis() at 'from'
+        uint32_t ms;
+    };
+
+    Adafruit_NeoPixel &_strip;
+    Fade _fades[FADER_MAX_FADES];
+    bool _show;              // a pixel changed: show() at the end of update()
+
+    Fade *find(uint16_t target, uint8_t channel);
+    Fade *slot(void);
+    void write(const Fade &f);
+};
+
+#endif // Fader_h
@@ -0,0 +1,68 @@
+#ifndef FixedPoint_h
+#define FixedPoint_h
+
+#include <inttypes.h>
+
+// Fixed-point temperatures and energies for the boiler calculations.
+//
+// The Photon (Cortex-M3) has no FPU: every double add, multiply or divide is
+// a call into the soft-float library. The T-BUS readings are integers to
+// begin with (1/16 °C), so they are kept as integers all the way:
+//
+//  - temperatures in centi-degrees, int16_t: 2150 = 21.50 °C (±327 °C)
+//  - energies in milli-kWh (= Wh), int32_t: 12345 = 12.345 kWh
+//
+// Convert to double only where a value leaves the device (JSON, publish,
+// "double" Particle.variables) with centiToDouble() / mkWhToDouble().
+//
+//    centi_t av = centiAverage(KSTopH, KSTopL);
+//    mkwh_t q = zoneEnergy(av, KSTmin, 66);
+//    snprintf(buf, len, "%.3f", mkWhToDouble(q));
+
+typedef int16_t centi_t;    // 1/100 °C
+typedef int32_t mkwh_t;     // 1/1000 kWh = Wh
+
+// Whole degrees to centi-degrees (constants): CENTI(25) = 2500
+#define CENTI(degrees) ((centi_t)((degrees) * 100))
+
+// kWh to milli-kWh (constants): MKWH(15) = 15000
+#define MKWH(kwh) ((mkwh_t)((kwh) * 1000))
+
+// Integer division rounded to nearest (halves away from zero). d > 0.
+inline int32_t divRound(int32_t n, int32_t d)
+{
+    return (n >= 0 ? n + d / 2 : n - d / 2) / d;
+}
+
+// DS18B20 temperature register (1/16 °C) to centi-degrees, rounded.
+inline centi_t rawToCenti(int16_t raw)
+{
+    return (centi_t)divRound((int32_t)raw * 100, 16);
+}
+
+// DS18S20 temperature register (1/2 °C) to centi-degrees.
+inline centi_t raw9ToCenti(int16_t raw)
+{
+    return (centi_t)(raw * 50);
+}
+
+// Mean of two temperatures (truncated to the 1/100 °C).
+inline centi_t centiAverage(centi_t a, centi_t b)
+{
+    return (centi_t)(((int32_t)a + b) / 2);
+}
+
+// Energy stored in 'liters' of water above 'tmin' (negative below it):
+// liters * 1.163 Wh/(l.K) * (t - tmin), rounded to the Wh (= milli-kWh).
+// Fits in the int32_t for liters * (t - tmin) up to 18000 l.K (110 liter
+// zone: 160 K).
+inline mkwh_t zoneEnergy(centi_t t, centi_t tmin, uint16_t liters)
+{
+    return divRound((int32_t)(t - tmin) * liters * 1163, 100000);
+}
+
+// At the publish boundary only:
+inline double centiToDouble(centi_t c) { return c * 0.01; }
+inline double mkWhToDouble(mkwh_t q) { return q * 0.001; }
+
+#endif // FixedPoint_h
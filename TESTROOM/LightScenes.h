@@ -0,0 +1,93 @@
+#ifndef LightScenes_h
+#define LightScenes_h
+
+#include <inttypes.h>
+#include "application.h"
+#include "neopixel.h"
+
+// Pixel n in a group (PowerPixels: the first 32 pixels of the line)
+#define LIGHT_PIXEL(n) ((uint32_t)1 << (n))
+
+// Scene colors: LIGHT_RGB() is Adafruit_NeoPixel::Color() for constant
+// tables, LIGHT_PICKED the color of the web color picker (setPicked()).
+#define LIGHT_RGB(r, g, b) (((uint32_t)(r) << 16) | ((uint32_t)(g) << 8) | (uint32_t)(b))
+#define LIGHT_OFF          LIGHT_RGB(0, 0, 0)
+#define LIGHT_PICKED       0xFF000000UL
+
+// Group number of the line that ends a scene
+#define LIGHT_END 0xFF
+
+// A named set of PowerPixels that is switched as one light
+struct LightGroup
+{
+    const char *name;
+    uint32_t pixels;    // LIGHT_PIXEL(0) | LIGHT_PIXEL(2)...
+};
+
+// One line of a scene: every pixel of 'group' gets 'color'
+struct LightScene
+{
+    uint8_t group;      // index in the group table, LIGHT_END = last line
+    uint32_t color;
+};
+
+// Light groups and scenes on top of the pixel line.
+//
+// The room sketches had the PowerPixel numbers in every ON/OFF function
+// (0 and 2 = MOV1, 1 = MOV2, 3 = STORE), with a setPixelColor() + show()
+// per pixel. Here the wiring is one table of groups, and a scene is a
+// constant list of "group = color" lines. apply() sets all pixels of the
+// scene and then calls show() once: one frame for the whole change.
+//
+//    enum { MOV1, MOV2, STORE };
+//    const LightGroup lightGroups[] = {
+//      { "MOV1",  LIGHT_PIXEL(0) | LIGHT_PIXEL(2) },
+//      { "MOV2",  LIGHT_PIXEL(1) },
+//      { "STORE", LIGHT_PIXEL(3) },
+//    };
+//    const LightScene MOV1on[] = { { MOV1, LIGHT_PICKED }, { LIGHT_END } };
+//
+//    LightScenes scenes(strip, lightGroups, 3);
+//    scenes.apply(MOV1on);
+class LightScenes
+{
+  public:
+    LightScenes(Adafruit_NeoPixel &strip, const LightGroup *groups, uint8_t count)
+        : _strip(strip), _groups(groups), _count(count), _picked(LIGHT_RGB(255, 255, 255)) {}
+
+    // Color used for LIGHT_PICKED (ledrgb(): the web color picker).
+    void setPicked(uint32_t color) { _picked = color & 0xFFFFFF; }
+    uint32_t picked(void) const { return _picked; }
+
+    // Set all pixels of group 'g' to 'color', without show().
+    void set(uint8_t g, uint32_t color)
+    {
+        uint32_t pixels;
+
+        if (g >= _count) return;
+        if (color == LIGHT_PICKED) color = _picked;
+
+        pixels = _groups[g].pixels;
+        for (uint16_t n = 0; pixels; n++, pixels >>= 1) {
+            if (pixels & 1) _strip.setPixelColor(n, color);
+        }
+    }
+
+    // Set every line of 'scene' (up to LIGHT_END), then one show().
+    void apply(const LightScene *scene)
+    {
+        for (; scene->group != LIGHT_END; scene++) set(scene->group, scene->color);
+        _strip.show();
+    }
+
+    // Name of group 'g' (status messages).
+    const char *name(uint8_t g) const { return g < _count ? _groups[g].name : ""; }
+
+  private:
+    Adafruit_NeoPixel &_strip;
+    const LightGroup *_groups;
+    uint8_t _count;
+    uint32_t _picked;
+};
+
+#endif // LightScenes_h
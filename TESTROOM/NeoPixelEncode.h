@@ -0,0 +1,118 @@
+#ifndef NeoPixelEncode_h
+#define NeoPixelEncode_h
+
+#include <inttypes.h>
+#include <stddef.h>
+
+// The pure part of the NeoPixel driver: byte order per pixel type and the
+// SPI waveform of the bitstream. No pins, no timing, no application.h, so
+// it also builds on a PC: a new encoder can be checked bit for bit against
+// these before it drives a ceiling light.
+//
+// The bitstream of every type is the pixel buffer in memory order, each
+// byte through the 'level' table (brightness + gamma), MSB first. The
+// bit-banged loops in neopixel.cpp send exactly that; the SPI output sends
+// neoPixelEncodeSPI() of it. Golden frames: SIM/NeoPixelTest.cpp.
+//
+// The bit-banged waveform itself stays in neopixel.cpp. Per bit it is a
+// pinSet() and a run of nops counted per platform (792/434 ns measured on
+// the Photon), with interrupts off: a call or a table lookup in there
+// moves those times, and without the GPIO registers it cannot run on a PC
+// anyway. Its data side, 3 bytes through level[] packed MSB first before
+// the timed loop, is the contract above.
+//
+//    uint8_t buf[3 * 2], spi[4 * 3 * 2];
+//    neoPixelPack(WS2812B, &buf[0], 255, 0, 0);    // GRB: 00 FF 00
+//    neoPixelPack(WS2812B, &buf[3], 0, 0, 100);
+//    neoPixelEncodeSPI(buf, sizeof(buf), level, spi);
+
+// 'type' flags for LED pixels (third parameter to the constructor):
+#define WS2812   0x02 // 800 KHz datastream (NeoPixel)
+#define WS2812B  0x02 // 800 KHz datastream (NeoPixel)
+#define WS2811   0x00 // 400 KHz datastream (NeoPixel)
+#define TM1803   0x03 // 400 KHz datastream (Radio Shack Tri-Color Strip)
+#define TM1829   0x04 // 800 KHz datastream ()
+#define WS2812B2 0x05 // 800 KHz datastream (NeoPixel)
+
+// Position of R, G and B within the 3 bytes of a pixel
+struct NeoPixelOrder
+{
+    uint8_t r, g, b;
+};
+
+inline NeoPixelOrder neoPixelOrder(uint8_t type)
+{
+    NeoPixelOrder o;
+
+    switch (type) {
+      case WS2812B:     // WS2812 & WS2812B is GRB order.
+      case WS2812B2:
+        o.r = 1; o.g = 0; o.b = 2;
+        break;
+      case TM1829:      // TM1829 is special RBG order
+        o.r = 0; o.g = 2; o.b = 1;
+        break;
+      case WS2811:      // WS2811 is RGB order
+      case TM1803:      // TM1803 is RGB order
+      default:          // default is RGB order
+        o.r = 0; o.g = 1; o.b = 2;
+        break;
+    }
+
+    return o;
+}
+
+// The same at compile time, for a 'type' known in the sketch:
+// NeoPixelOrderOf<WS2812B>::r == 1 (see Adafruit_NeoPixelStatic).
+template <uint8_t TYPE>
+struct NeoPixelOrderOf
+{
+    static const uint8_t r = (TYPE == WS2812B || TYPE == WS2812B2) ? 1 : 0;
+    static const uint8_t g = (TYPE == WS2812B || TYPE == WS2812B2) ? 0 : (TYPE == TM1829) ? 2 : 1;
+    static const uint8_t b = (TYPE == TM1829) ? 1 : 2;
+};
+
+// Store one pixel in the byte order of 'type'.
+inline void neoPixelPack(uint8_t type, uint8_t *p, uint8_t r, uint8_t g, uint8_t b)
+{
+    NeoPixelOrder o = neoPixelOrder(type);
+
+    if (type == TM1829 && r == 255) r = 254;    // 255 on RED channel causes display to be in a special mode.
+    p[o.r] = r;
+    p[o.g] = g;
+    p[o.b] = b;
+}
+
+// One pixel back to a packed 0x00RRGGBB color (Adafruit_NeoPixel::Color()).
+inline uint32_t neoPixelUnpack(uint8_t type, const uint8_t *p)
+{
+    NeoPixelOrder o = neoPixelOrder(type);
+
+    return ((uint32_t)p[o.r] << 16) | ((uint32_t)p[o.g] << 8) | p[o.b];
+}
+
+// SPI output: 4 SPI bits per WS2812 bit, so one pixel byte = 4 SPI bytes.
+// Pattern of each 4-bit nibble (MSB first): 1 -> 1110, 0 -> 1000.
+static const uint16_t neoPixelSpiPattern[16] = {
+    0x8888, 0x888E, 0x88E8, 0x88EE, 0x8E88, 0x8E8E, 0x8EE8, 0x8EEE,
+    0xE888, 0xE88E, 0xE8E8, 0xE8EE, 0xEE88, 0xEE8E, 0xEEE8, 0xEEEE
+};
+
+// Encode 'count' buffer bytes, each through level[] (NULL: as they are),
+// into 4 * count SPI bytes at 'out'. Returns the end of the output.
+inline uint8_t *neoPixelEncodeSPI(const uint8_t *bytes, size_t count, const uint8_t *level, uint8_t *out)
+{
+    for (size_t k = 0; k < count; k++) {
+        uint8_t v = level ? level[bytes[k]] : bytes[k];
+        uint16_t hi = neoPixelSpiPattern[v >> 4], lo = neoPixelSpiPattern[v & 0x0F];
+
+        *out++ = hi >> 8;
+        *out++ = hi;
+        *out++ = lo >> 8;
+        *out++ = lo;
+    }
+
+    return out;
+}
+
+#endif // NeoPixelEncode_h
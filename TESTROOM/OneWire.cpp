@@ -149,7 +149,122 @@ OneWire::OneWire(uint16_t pin)
 {
     pinMode(pin, INPUT);
     _pin = pin;
+#if ONEWIRE_STATS
+    clearStats();
+#endif
+}
+
+OneWire::OneWire(void)
+{
+    _pin = 0;
+#if ONEWIRE_STATS
+    clearStats();
+#endif
+}
+
+#if ONEWIRE_STATS
+void OneWire::clearStats(void)
+{
+    memset(&_stats, 0, sizeof(_stats));
+    _hasSelected = false;
+}
+
+void OneWire::countReset(uint8_t presence, bool timeout)
+{
+    _stats.resets++;
+    if (!presence) _stats.presenceFailures++;
+    if (timeout) _stats.resetTimeouts++;
+}
+
+void OneWire::countIrqOff(uint16_t us)
+{
+    _stats.irqOffMicros += us;
+}
+
+void OneWire::countBytes(uint16_t n)
+{
+    _stats.bytes += n;
+}
+
+void OneWire::countSelect(const uint8_t *rom)
+{
+    _hasSelected = (rom != 0);
+    if (rom) memcpy(_selected, rom, 8);
+}
+
+void OneWire::countEcho(bool ok)
+{
+    if (!ok) _stats.echoErrors++;
+}
+
+void OneWire::countPower(bool ok)
+{
+    if (ok) _stats.powerWrites++;
+    else _stats.powerErrors++;
 }
+
+void OneWire::countRead(uint8_t result)
+{
+    uint8_t i;
+
+    if (result == ONEWIRE_READ_OK) return;
+
+    _stats.readErrors++;
+    if (!_hasSelected) return;    // skip ROM: no sensor to blame
+
+    for (i = 0; i < _stats.roms; i++) {
+        if (memcmp(_stats.rom[i], _selected, 8) == 0) break;
+    }
+    if (i == _stats.roms) {
+        if (i == ONEWIRE_STATS_ROMS) return;    // table full: only in the total
+        memcpy(_stats.rom[i], _selected, 8);
+        _stats.romErrors[i] = 0;
+        _stats.roms++;
+    }
+    if (_stats.romErrors[i] < 0xFFFF) _stats.romErrors[i]++;
+}
+
+int OneWire::statsJSON(char *buf, size_t len) const
+{
+    return statsJSON(_stats, buf, len);
+}
+
+int OneWire::statsJSON(const OneWireStats &stats, char *buf, size_t len)
+{
+    int n;
+
+    if (len == 0) return 0;
+
+    n = snprintf(buf, len, "{\"rst\":%lu,\"nopres\":%lu,\"tmo\":%lu,\"err\":%lu,\"echo\":%lu,\"pow\":%lu,\"nopow\":%lu,\"bytes\":%lu,\"irq_us\":%lu,\"roms\":{",
+                 (unsigned long)stats.resets, (unsigned long)stats.presenceFailures,
+                 (unsigned long)stats.resetTimeouts, (unsigned long)stats.readErrors,
+                 (unsigned long)stats.echoErrors, (unsigned long)stats.powerWrites, (unsigned long)stats.powerErrors,
+                 (unsigned long)stats.bytes, (unsigned long)stats.irqOffMicros);
+    if (n < 0 || (size_t)n + 3 > len) { buf[0] = 0; return 0; }
+
+    for (uint8_t i = 0; i < stats.roms; i++) {
+        const uint8_t *r = stats.rom[i];
+        char entry[32];
+        int w = snprintf(entry, sizeof(entry), "%s\"%02X%02X%02X%02X%02X%02X%02X%02X\":%u", i ? "," : "",
+                         r[0], r[1], r[2], r[3], r[4], r[5], r[6], r[7], stats.romErrors[i]);
+        if ((size_t)(n + w) + 3 > len) break;    // keep room for "}}"
+        memcpy(buf + n, entry, w + 1);
+        n += w;
+    }
+
+    memcpy(buf + n, "}}", 3);
+
+    return n + 2;
+}
+#else
+void OneWire::countReset(uint8_t presence, bool timeout) {}
+void OneWire::countIrqOff(uint16_t us) {}
+void OneWire::countBytes(uint16_t n) {}
+void OneWire::countSelect(const uint8_t *rom) {}
+void OneWire::countRead(uint8_t result) {}
+void OneWire::countEcho(bool ok) {}
+void OneWire::countPower(bool ok) {}
+#endif
 // Perform the onewire reset function.  We will wait up to 250uS for
 // the bus to come high, if it doesn't then it is broken or shorted
 // and we return a 0;
@@ -166,7 +281,10 @@ uint8_t OneWire::reset(void)
     interrupts();
     // wait until the wire is high... just in case
     do {
-        if (--retries == 0) return 0;
+        if (--retries == 0) {
+            countReset(0, true);
+            return 0;
+        }
 
         delayMicroseconds(2);
     } while ( !digitalReadFast());
@@ -187,6 +305,8 @@ uint8_t OneWire::reset(void)
     r =! digitalReadFast();
 
     interrupts();
+    countIrqOff(70);
+    countReset(r, false);
 
     delayMicroseconds(410);
 
@@ -206,6 +326,7 @@ void OneWire::write_bit(uint8_t v)
         pinModeFastInput();    // float high
 
         interrupts();
+        countIrqOff(10);
 
         delayMicroseconds(55);
     } else {
@@ -219,6 +340,7 @@ void OneWire::write_bit(uint8_t v)
         pinModeFastInput();    // float high
 
         interrupts();
+        countIrqOff(65);
 
         delayMicroseconds(5);
     }
@@ -246,6 +368,7 @@ uint8_t OneWire::read_bit(void)
     r = digitalReadFast();
 
     interrupts();
+    countIrqOff(13);
     delayMicroseconds(53);
 
     return r;
@@ -263,8 +386,9 @@ void OneWire::write(uint8_t v, uint8_t power /* = 0 */)
     uint8_t bitMask;
 
     for (bitMask = 0x01; bitMask; bitMask <<= 1) {
-        OneWire::write_bit( (bitMask & v)?1:0);
+        write_bit( (bitMask & v)?1:0);
     }
+    countBytes(1);
 
     if ( power) {
         noInterrupts();
@@ -273,22 +397,16 @@ void OneWire::write(uint8_t v, uint8_t power /* = 0 */)
         pinModeFastOutput();        // Drive pin High when power is True
 
         interrupts();
+        countPower(true);
     }
 }
 
 void OneWire::write_bytes(const uint8_t *buf, uint16_t count, bool power /* = 0 */) 
 {
+    // Power after the last byte through the (virtual) write(), so a backend
+    // without a GPIO pin handles it too
     for (uint16_t i = 0 ; i < count ; i++)
-        write(buf[i]);
-
-    if (power) {
-        noInterrupts();
-
-        digitalWriteFastHigh();
-        pinModeFastOutput();        // Drive pin High when power is True
-
-        interrupts();
-    }
+        write(buf[i], power && i + 1 == count);
 }
 
 //
@@ -300,8 +418,9 @@ uint8_t OneWire::read()
     uint8_t r = 0;
 
     for (bitMask = 0x01; bitMask; bitMask <<= 1) {
-        if ( OneWire::read_bit()) r |= bitMask;
+        if ( read_bit()) r |= bitMask;
     }
+    countBytes(1);
 
     return r;
 }
@@ -312,6 +431,46 @@ void OneWire::read_bytes(uint8_t *buf, uint16_t count)
         buf[i] = read();
 }
 
+#if ONEWIRE_CRC
+uint8_t OneWire::read_scratchpad_checked(uint8_t *buf, uint8_t len, uint8_t family /* = 0 */)
+{
+    uint8_t crc = 0;
+    uint8_t same = 0;    // number of leading bytes equal to buf[0]
+    uint8_t dead = 0;    // bytes of 0xFF/0x00 after which the bus is dead
+    uint8_t result;
+
+    for (uint8_t i = 0; i < len; i++) {
+        buf[i] = read();
+
+        if (i == 0) dead = deadBusBytes(buf[0], family);
+        if (buf[i] == buf[0] && same == i) same++;
+
+        // A dead bus reads as a constant 0xFF or 0x00: stop as soon as no
+        // real scratchpad can look like this
+        if (dead && same == dead) {
+            reset();
+            result = buf[0] ? ONEWIRE_READ_ABSENT : ONEWIRE_READ_SHORTED;
+            countRead(result);
+            return result;
+        }
+
+        if (i + 1 < len) crc = crc8_update(crc, buf[i]);
+    }
+
+    // Short reads ('len' below the abort point): a constant over all of it.
+    // Checked first: bytes of 0x00 have a matching CRC.
+    if (len && same == len && (buf[0] == 0xFF || buf[0] == 0x00))
+        result = buf[0] ? ONEWIRE_READ_ABSENT : ONEWIRE_READ_SHORTED;
+    else
+        result = (len && crc == buf[len - 1]) ? ONEWIRE_READ_OK : ONEWIRE_READ_CRC_ERROR;
+
+    if (result != ONEWIRE_READ_OK) reset();    // leave the bus idle for the next command
+    countRead(result);
+
+    return result;
+}
+#endif
+
 //
 // Do a ROM select
 //
@@ -319,6 +478,7 @@ void OneWire::select(const uint8_t rom[8])
 {
     uint8_t i;
 
+    countSelect(rom);
     write(0x55);           // Choose ROM
 
     for (i = 0; i < 8; i++) write(rom[i]);
@@ -329,6 +489,7 @@ void OneWire::select(const uint8_t rom[8])
 //
 void OneWire::skip()
 {
+    countSelect(0);
     write(0xCC);           // Skip ROM
 }
 
@@ -393,7 +554,7 @@ void OneWire::target_search(uint8_t family_code)
 // Return TRUE  : device found, ROM number in ROM_NO buffer
 //        FALSE : device not found, end of search
 //
-uint8_t OneWire::search(uint8_t *newAddr)
+uint8_t OneWire::search(uint8_t *newAddr, bool search_mode /* = true */)
 {
     uint8_t id_bit_number;
     uint8_t last_zero, rom_byte_number, search_result;
@@ -421,8 +582,12 @@ uint8_t OneWire::search(uint8_t *newAddr)
             return FALSE;
         }
 
-        // issue the search command
-        write(0xF0);
+        // issue the search command: normal or conditional (alarm) search
+        if (search_mode) {
+            write(0xF0);
+        } else {
+            write(0xEC);
+        }
 
         // loop to do the search
         do
@@ -519,6 +684,51 @@ uint8_t OneWire::search(uint8_t *newAddr)
 //
 
 
+#if ONEWIRE_CRC8_TABLE
+// This table comes from Dallas sample code where it is freely reusable,
+// though Copyright (C) 2000 Dallas Semiconductor Corporation
+static const uint8_t dscrc_table[] = {
+      0,  94, 188, 226,  97,  63, 221, 131, 194, 156, 126,  32, 163, 253,  31,  65,
+    157, 195,  33, 127, 252, 162,  64,  30,  95,   1, 227, 189,  62,  96, 130, 220,
+     35, 125, 159, 193,  66,  28, 254, 160, 225, 191,  93,   3, 128, 222,  60,  98,
+    190, 224,   2,  92, 223, 129,  99,  61, 124,  34, 192, 158,  29,  67, 161, 255,
+     70,  24, 250, 164,  39, 121, 155, 197, 132, 218,  56, 102, 229, 187,  89,   7,
+    219, 133, 103,  57, 186, 228,   6,  88,  25,  71, 165, 251, 120,  38, 196, 154,
+    101,  59, 217, 135,   4,  90, 184, 230, 167, 249,  27,  69, 198, 152, 122,  36,
+    248, 166,  68,  26, 153, 199,  37, 123,  58, 100, 134, 216,  91,   5, 231, 185,
+    140, 210,  48, 110, 237, 179,  81,  15,  78,  16, 242, 172,  47, 113, 147, 205,
+     17,  79, 173, 243, 112,  46, 204, 146, 211, 141, 111,  49, 178, 236,  14,  80,
+    175, 241,  19,  77, 206, 144, 114,  44, 109,  51, 209, 143,  12,  82, 176, 238,
+     50, 108, 142, 208,  83,  13, 239, 177, 240, 174,  76,  18, 145, 207,  45, 115,
+    202, 148, 118,  40, 171, 245,  23,  73,   8,  86, 180, 234, 105,  55, 213, 139,
+     87,   9, 235, 181,  54, 104, 138, 212, 149, 203,  41, 119, 244, 170,  72,  22,
+    233, 183,  85,  11, 136, 214,  52, 106,  43, 117, 151, 201,  74,  20, 246, 168,
+    116,  42, 200, 150,  21,  75, 169, 247, 182, 232,  10,  84, 215, 137, 107,  53
+};
+
+//
+// Compute a Dallas Semiconductor 8 bit CRC. These show up in the ROM
+// and the registers.  (note: this might better be done without to
+// table, it would probably be smaller and certainly fast enough
+// compared to all those delayMicrosecond() calls.  But I got
+// confused, so I use this table from the examples.)
+//
+uint8_t OneWire::crc8( uint8_t *addr, uint8_t len)
+{
+    uint8_t crc = 0;
+
+    while (len--) {
+        crc = dscrc_table[crc ^ *addr++];
+    }
+
+    return crc;
+}
+
+uint8_t OneWire::crc8_update(uint8_t crc, uint8_t data)
+{
+    return dscrc_table[crc ^ data];
+}
+#else
 //
 // Compute a Dallas Semiconductor 8 bit CRC directly.
 // this is much slower, but much smaller, than the lookup table.
@@ -539,6 +749,19 @@ uint8_t OneWire::crc8( uint8_t *addr, uint8_t len)
 
     return crc;
 }
+
+uint8_t OneWire::crc8_update(uint8_t crc, uint8_t data)
+{
+    for (uint8_t i = 8; i; i--) {
+        uint8_t mix = (crc ^ data) & 0x01;
+        crc >>= 1;
+        if (mix) crc ^= 0x8C;
+        data >>= 1;
+    }
+
+    return crc;
+}
+#endif
 #endif
 
 #if ONEWIRE_CRC16
@@ -549,6 +772,52 @@ bool OneWire::check_crc16(const uint8_t* input, uint16_t len, const uint8_t* inv
     return (crc & 0xFF) == inverted_crc[0] && (crc >> 8) == inverted_crc[1];
 }
 
+#if ONEWIRE_CRC16_TABLE
+// CRC16 (x^16 + x^15 + x^2 + 1, reflected) of every byte value.
+static const uint16_t crc16_table[] = {
+    0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
+    0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
+    0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
+    0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841,
+    0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40,
+    0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41,
+    0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641,
+    0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040,
+    0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240,
+    0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441,
+    0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41,
+    0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840,
+    0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41,
+    0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40,
+    0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640,
+    0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041,
+    0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240,
+    0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441,
+    0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41,
+    0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840,
+    0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41,
+    0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40,
+    0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640,
+    0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041,
+    0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241,
+    0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440,
+    0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40,
+    0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841,
+    0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
+    0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
+    0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
+    0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040
+};
+
+uint16_t OneWire::crc16(const uint8_t* input, uint16_t len, uint16_t crc)
+{
+    for (uint16_t i = 0 ; i < len ; i++) {
+        crc = (crc >> 8) ^ crc16_table[(crc ^ input[i]) & 0xff];
+    }
+
+    return crc;
+}
+#else
 uint16_t OneWire::crc16(const uint8_t* input, uint16_t len, uint16_t crc)
 {
     static const uint8_t oddparity[16] =
@@ -573,3 +842,4 @@ uint16_t OneWire::crc16(const uint8_t* input, uint16_t len, uint16_t crc)
     return crc;
 }
 #endif
+#endif
@@ -14,6 +14,12 @@
 #define ONEWIRE_CRC 1
 #endif
 
+// Select the table-lookup version of the 8-bit CRC, which is faster
+// than computing it bit by bit but costs 256 bytes of flash.
+// Define this to 0 for flash-tight builds.
+#ifndef ONEWIRE_CRC8_TABLE
+#define ONEWIRE_CRC8_TABLE 1
+#endif
 
 
 // You can allow 16-bit CRC checks by defining this to 1
@@ -22,6 +28,46 @@
 #define ONEWIRE_CRC16 1
 #endif
 
+// Same for the 16-bit CRC: 512 bytes of flash when set to 1.
+#ifndef ONEWIRE_CRC16_TABLE
+#define ONEWIRE_CRC16_TABLE 1
+#endif
+
+// Results of read_scratchpad_checked()
+#define ONEWIRE_READ_CRC_ERROR 0    // all bytes read, CRC does not match
+#define ONEWIRE_READ_OK        1    // CRC matches
+#define ONEWIRE_READ_ABSENT    2    // only 0xFF: nothing drives the bus (sensor missing)
+#define ONEWIRE_READ_SHORTED   3    // only 0x00: bus held low (short, faulty sensor)
+
+// Bus health counters, see stats() and statsJSON(). Define this to 0 to
+// leave them out (saves ~160 bytes of RAM per bus).
+#ifndef ONEWIRE_STATS
+#define ONEWIRE_STATS 1
+#endif
+
+// Number of ROMs whose failed scratchpad reads are counted separately.
+#ifndef ONEWIRE_STATS_ROMS
+#define ONEWIRE_STATS_ROMS 12
+#endif
+
+#if ONEWIRE_STATS
+struct OneWireStats
+{
+    uint32_t resets;
+    uint32_t presenceFailures;    // reset without presence pulse
+    uint32_t resetTimeouts;       // bus still low before the reset (> 250uS): short, faulty sensor
+    uint32_t readErrors;          // read_scratchpad_checked() not OK: CRC error, absent or shorted
+    uint32_t echoErrors;          // written byte read back different (UART backend): contention, short
+    uint32_t powerWrites;         // write() with power = 1: strong pull-up held for a parasite sensor
+    uint32_t powerErrors;         // write() with power = 1 on a backend without strong pull-up (UART)
+    uint32_t bytes;               // bytes written and read
+    uint32_t irqOffMicros;        // time with interrupts disabled: estimate, see statsJSON()
+    uint8_t roms;                 // entries used in rom[]/romErrors[]
+    uint8_t rom[ONEWIRE_STATS_ROMS][8];
+    uint16_t romErrors[ONEWIRE_STATS_ROMS];
+};
+#endif
+
 // TRUE and FALSE are defined by default on the Spark
 // #define FALSE 0
 // #define TRUE  1
@@ -156,13 +202,37 @@ private:
     uint8_t LastDeviceFlag;
 #endif
 
+#if ONEWIRE_STATS
+    OneWireStats _stats;
+    uint8_t _selected[8];    // last select() ROM, for the per ROM read errors
+    bool _hasSelected;
+#endif
+
+  protected:
+    // For backends that do not bit-bang a GPIO pin (see OneWireUART).
+    OneWire(void);
+
+    // Statistics hooks for backends that replace reset() or the bit slots.
+    // Empty when ONEWIRE_STATS is 0.
+    void countReset(uint8_t presence, bool timeout);
+    void countIrqOff(uint16_t us);
+    void countBytes(uint16_t n);
+    void countSelect(const uint8_t *rom);
+    void countRead(uint8_t result);
+    void countEcho(bool ok);
+    void countPower(bool ok);
+
   public:
     OneWire( uint16_t pin);
 
+    // The bus primitives below are virtual so another backend (ex:
+    // OneWireUART) can replace the GPIO bit-banging. select(), skip(),
+    // search() and the byte helpers are built on them and work unchanged.
+
     // Perform a 1-Wire reset cycle. Returns 1 if a device responds
     // with a presence pulse.  Returns 0 if there is no device or the
     // bus is shorted or otherwise held low for more than 250uS
-    uint8_t reset(void);
+    virtual uint8_t reset(void);
 
     // Issue a 1-Wire rom select command, you do the reset first.
     void select(const uint8_t rom[8]);
@@ -174,28 +244,72 @@ private:
     // the end for parasitically powered devices. You are responsible
     // for eventually depowering it by calling depower() or doing
     // another read or write.
-    void write(uint8_t v, uint8_t power = 0);
+    virtual void write(uint8_t v, uint8_t power = 0);
 
     void write_bytes(const uint8_t *buf, uint16_t count, bool power = 0);
 
     // Read a byte.
-    uint8_t read(void);
+    virtual uint8_t read(void);
 
     void read_bytes(uint8_t *buf, uint16_t count);
 
+#if ONEWIRE_CRC
+    // Read a scratchpad of 'len' bytes whose last byte is the CRC8 of the
+    // others (DS18B20: 9 bytes), after you did reset(), select() and the
+    // Read Scratchpad command. The CRC is updated as each byte arrives.
+    // A dead bus (a constant 0xFF or 0x00) is given up on with a reset() as
+    // soon as no real scratchpad can look like it, see deadBusBytes():
+    // 'family' is the family code of the selected sensor (0 = unknown).
+    // Any other read that is not OK also ends with a reset().
+    // Returns one of the ONEWIRE_READ_... results.
+    uint8_t read_scratchpad_checked(uint8_t *buf, uint8_t len, uint8_t family = 0);
+
+    // Number of leading bytes of value 'v' after which a scratchpad read is
+    // a dead bus, 0 if 'v' is neither 0xFF nor 0x00:
+    //  - 0x00: 5 bytes. Byte 4 is the config register of a DS18B20 (0x1F..
+    //    0x7F) or the fixed 0xFF of a DS18S20, never 0x00.
+    //  - 0xFF: 5 bytes for a DS18B20 (family 0x28), same config byte. For
+    //    others 8: a DS18S20 at -0.5 °C with TH/TL at -1 °C sends FF up to
+    //    byte 5, but byte 7 (COUNT_PER_C) is always 0x10.
+    static uint8_t deadBusBytes(uint8_t v, uint8_t family)
+    {
+        if (v == 0x00) return 5;
+        if (v == 0xFF) return (family == 0x28) ? 5 : 8;
+        return 0;
+    }
+#endif
+
     // Write a bit. The bus is always left powered at the end, see
     // note in write() about that.
-    void write_bit(uint8_t v);
+    virtual void write_bit(uint8_t v);
 
     // Read a bit.
-    uint8_t read_bit(void);
+    virtual uint8_t read_bit(void);
 
     // Stop forcing power onto the bus. You only need to do this if
     // you used the 'power' flag to write() or used a write_bit() call
     // and aren't about to do another read or write. You would rather
     // not leave this powered if you don't have to, just in case
     // someone shorts your bus.
-    void depower(void);
+    virtual void depower(void);
+
+#if ONEWIRE_STATS
+    // Bus health counters since start-up or clearStats().
+    const OneWireStats &stats(void) const { return _stats; }
+    void clearStats(void);
+
+    // The counters as one compact JSON, ex: for a Particle.variable:
+    //   {"rst":8640,"nopres":0,"tmo":0,"err":3,"echo":0,"pow":0,"nopow":0,"bytes":95040,"irq_us":1712,"roms":{"28DBB503000080BB":3}}
+    // "irq_us" is an estimate, not a measurement: the nominal length of the
+    // interrupts-off part of each slot (reset 70, write 10/65, read 13 us)
+    // added up; the code around the delays is not timed. The UART backend
+    // masks no interrupts and counts 0.
+    // ROMs that do not fit in 'len' are left out. Returns the length.
+    int statsJSON(char *buf, size_t len) const;
+
+    // Same for any counters, ex: those of several buses added up.
+    static int statsJSON(const OneWireStats &stats, char *buf, size_t len);
+#endif
 
 #if ONEWIRE_SEARCH
     // Clear the search state so that if will start from the beginning again.
@@ -211,7 +325,10 @@ private:
     // might be a good idea to check the CRC to make sure you didn't
     // get garbage.  The order is deterministic. You will always get
     // the same devices in the same order.
-    uint8_t search(uint8_t *newAddr);
+    // With search_mode false, a conditional search (0xEC) is done: only
+    // devices with their alarm flag set answer (ex: a DS18B20 whose last
+    // conversion was above TH or below TL).
+    uint8_t search(uint8_t *newAddr, bool search_mode = true);
 #endif
 
 #if ONEWIRE_CRC
@@ -219,6 +336,9 @@ private:
     // ROM and scratchpad registers.
     static uint8_t crc8(uint8_t *addr, uint8_t len);
 
+    // Add one byte to a running 8 bit CRC (start with crc = 0).
+    static uint8_t crc8_update(uint8_t crc, uint8_t data);
+
 #if ONEWIRE_CRC16
     // Compute the 1-Wire CRC16 and compare it against the received CRC.
     // Example usage (reading a DS2408):
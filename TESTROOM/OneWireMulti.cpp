@@ -0,0 +1,260 @@
+/*
+
+OneWireMulti - Several 1-Wire buses in lockstep (see OneWireMulti.h).
+
+Timeslots as in Maxim Application Note 126 "1-Wire Communication Through
+Software": one combined slot serves write 1, write 0 and read, so every bus
+can do its own thing in the same slot:
+
+   all low 6uS -> release the 1/read buses -> sample at 15uS
+               -> release the 0 buses at 60uS -> recovery 10uS
+
+*/
+
+#include "OneWireMulti.h"
+#include "application.h"
+
+OneWireMulti::OneWireMulti(const uint16_t *pins, uint8_t count)
+{
+    if (count > ONEWIRE_MULTI_MAX_BUSES) count = ONEWIRE_MULTI_MAX_BUSES;
+    _count = count;
+
+    for (uint8_t b = 0; b < _count; b++) {
+        _pins[b] = pins[b];
+        pinMode(_pins[b], OUTPUT_OPEN_DRAIN);
+        pinSetFast(_pins[b]);    // released: the pull-up holds the bus high
+        _bus[b].attach(this, 1 << b);
+    }
+
+#if PLATFORM_ID == 6 || PLATFORM_ID == 8 || PLATFORM_ID == 10
+    STM32_Pin_Info *PIN_MAP = HAL_Pin_Map();
+
+    _port = PIN_MAP[_pins[0]].gpio_peripheral;
+    for (uint8_t b = 0; b < _count; b++) {
+        _portMask[b] = PIN_MAP[_pins[b]].gpio_pin;
+        if (PIN_MAP[_pins[b]].gpio_peripheral != _port) _port = 0;    // spread over ports: pin by pin
+    }
+#endif
+}
+
+uint8_t OneWireMulti::reset(uint8_t mask)
+{
+    uint8_t r;
+    uint8_t retries = 125;
+
+    mask &= all();
+
+    // wait until the wires are high... just in case
+    while ((sample() & mask) != mask) {
+        if (--retries == 0) {
+            uint8_t low = mask & ~sample();
+
+            for (uint8_t b = 0; b < _count; b++) {
+                if (low & (1 << b)) _bus[b].countReset(0, true);
+            }
+            mask &= ~low;    // go on with the buses that are not held low
+            break;
+        }
+        delayMicroseconds(2);
+    }
+    if (!mask) return 0;
+
+    driveLow(mask);
+    delayMicroseconds(480);
+
+    noInterrupts();
+    release(mask);
+    delayMicroseconds(70);
+    r = ~sample() & mask;    // presence pulse = low
+    interrupts();
+
+    for (uint8_t b = 0; b < _count; b++) {
+        if (!(mask & (1 << b))) continue;
+        _bus[b].countIrqOff(70);
+        _bus[b].countReset(r & (1 << b), false);
+    }
+
+    delayMicroseconds(410);
+
+    return r;
+}
+
+uint8_t OneWireMulti::touch(uint8_t mask, uint8_t ones)
+{
+    uint8_t r;
+
+    mask &= all();
+    ones &= mask;
+
+    noInterrupts();
+
+    driveLow(mask);
+    delayMicroseconds(6);
+
+    release(ones);    // write 1 or read: let the pull-up (or the sensor) decide
+    delayMicroseconds(9);
+
+    r = sample() & mask;
+
+    delayMicroseconds(45);
+    release(mask);    // end of the write 0 pulses
+
+    interrupts();
+
+    for (uint8_t b = 0; b < _count; b++) {
+        if (mask & (1 << b)) _bus[b].countIrqOff(60);
+    }
+
+    delayMicroseconds(10);
+
+    return r;
+}
+
+void OneWireMulti::write(uint8_t mask, const uint8_t *v)
+{
+    for (uint8_t bitMask = 0x01; bitMask; bitMask <<= 1) {
+        uint8_t ones = 0;
+
+        for (uint8_t b = 0; b < _count; b++) {
+            if (v[b] & bitMask) ones |= 1 << b;
+        }
+        touch(mask, ones);
+    }
+
+    for (uint8_t b = 0; b < _count; b++) {
+        if (mask & (1 << b)) _bus[b].countBytes(1);
+    }
+}
+
+void OneWireMulti::write(uint8_t mask, uint8_t v)
+{
+    uint8_t bytes[ONEWIRE_MULTI_MAX_BUSES];
+
+    memset(bytes, v, sizeof(bytes));
+    write(mask, bytes);
+}
+
+void OneWireMulti::read(uint8_t mask, uint8_t *v)
+{
+    for (uint8_t b = 0; b < _count; b++) v[b] = 0;
+
+    for (uint8_t bitMask = 0x01; bitMask; bitMask <<= 1) {
+        uint8_t r = touch(mask, mask);
+
+        for (uint8_t b = 0; b < _count; b++) {
+            if (r & (1 << b)) v[b] |= bitMask;
+        }
+    }
+
+    for (uint8_t b = 0; b < _count; b++) {
+        if (mask & (1 << b)) _bus[b].countBytes(1);
+    }
+}
+
+void OneWireMulti::select(uint8_t mask, const uint8_t *const *roms)
+{
+    uint8_t bytes[ONEWIRE_MULTI_MAX_BUSES];
+
+    for (uint8_t b = 0; b < _count; b++) {
+        if (mask & (1 << b)) _bus[b].countSelect(roms[b]);
+    }
+
+    write(mask, 0x55);    // Choose ROM
+
+    for (uint8_t i = 0; i < 8; i++) {
+        for (uint8_t b = 0; b < _count; b++) bytes[b] = (mask & (1 << b)) ? roms[b][i] : 0xFF;
+        write(mask, bytes);
+    }
+}
+
+uint8_t OneWireMulti::read_scratchpads(uint8_t mask, uint8_t (*buf)[9], uint8_t len, uint8_t *result, const uint8_t *family /* = 0 */)
+{
+    uint8_t crc[ONEWIRE_MULTI_MAX_BUSES];
+    uint8_t same[ONEWIRE_MULTI_MAX_BUSES];    // number of leading bytes equal to buf[b][0]
+    uint8_t dead[ONEWIRE_MULTI_MAX_BUSES];    // bytes of 0xFF/0x00 after which bus b is dead
+    uint8_t v[ONEWIRE_MULTI_MAX_BUSES];
+    uint8_t ok = 0;
+    uint8_t started = mask & all();
+
+    if (len > 9) len = 9;
+
+    for (uint8_t b = 0; b < _count; b++) {
+        crc[b] = 0;
+        same[b] = 0;
+        dead[b] = 0;
+        result[b] = ONEWIRE_READ_CRC_ERROR;
+    }
+
+    for (uint8_t i = 0; i < len && mask; i++) {
+        read(mask, v);
+
+        for (uint8_t b = 0; b < _count; b++) {
+            if (!(mask & (1 << b))) continue;
+
+            buf[b][i] = v[b];
+            if (i == 0) dead[b] = OneWire::deadBusBytes(v[b], family ? family[b] : 0);
+            if (v[b] == buf[b][0] && same[b] == i) same[b]++;
+
+            // A dead bus reads as a constant 0xFF or 0x00: drop it from the
+            // lockstep as soon as no real scratchpad can look like this
+            if (dead[b] && same[b] == dead[b]) {
+                result[b] = v[b] ? ONEWIRE_READ_ABSENT : ONEWIRE_READ_SHORTED;
+                mask &= ~(1 << b);
+                continue;
+            }
+
+            if (i + 1 < len) { crc[b] = OneWire::crc8_update(crc[b], v[b]); continue; }
+
+            // Short reads: a constant over all 'len' bytes
+            if (same[b] == len && (v[b] == 0xFF || v[b] == 0x00))
+                result[b] = v[b] ? ONEWIRE_READ_ABSENT : ONEWIRE_READ_SHORTED;
+            else if (crc[b] == v[b]) { result[b] = ONEWIRE_READ_OK; ok |= 1 << b; }
+        }
+    }
+
+    for (uint8_t b = 0; b < _count; b++) {
+        if (started & (1 << b)) _bus[b].countRead(result[b]);
+    }
+
+    // Like read_scratchpad_checked(): a bus that did not read OK (dropped
+    // early or not) is reset, so it starts the next lockstep command idle
+    // and not in the middle of a frame
+    if (started & ~ok) reset(started & ~ok);
+
+    return ok;
+}
+
+void OneWireMulti::depower(uint8_t mask)
+{
+    release(mask & all());
+}
+
+#if ONEWIRE_STATS
+int OneWireMulti::statsJSON(char *buf, size_t len) const
+{
+    OneWireStats sum;
+
+    memset(&sum, 0, sizeof(sum));
+    for (uint8_t b = 0; b < _count; b++) {
+        const OneWireStats &s = _bus[b].stats();
+
+        sum.resets += s.resets;
+        sum.presenceFailures += s.presenceFailures;
+        sum.resetTimeouts += s.resetTimeouts;
+        sum.readErrors += s.readErrors;
+        sum.echoErrors += s.echoErrors;
+        sum.powerWrites += s.powerWrites;
+        sum.powerErrors += s.powerErrors;
+        sum.bytes += s.bytes;
+        if (s.irqOffMicros > sum.irqOffMicros) sum.irqOffMicros = s.irqOffMicros;    // lockstep slots overlap
+
+        // A sensor is on one bus only: no duplicates
+        for (uint8_t i = 0; i < s.roms && sum.roms < ONEWIRE_STATS_ROMS; i++) {
+            memcpy(sum.rom[sum.roms], s.rom[i], 8);
+            sum.romErrors[sum.roms++] = s.romErrors[i];
+        }
+    }
+
+    return OneWire::statsJSON(sum, buf, len);
+}
+#endif
@@ -0,0 +1,183 @@
+#ifndef OneWireMulti_h
+#define OneWireMulti_h
+
+#include <inttypes.h>
+#include "application.h"
+#include "OneWire.h"
+
+// Maximum number of 1-Wire buses driven in lockstep. Buses are kept as bits
+// in a uint8_t.
+#ifndef ONEWIRE_MULTI_MAX_BUSES
+#define ONEWIRE_MULTI_MAX_BUSES 4
+#endif
+
+// Several 1-Wire buses (one GPIO pin each) driven in lockstep.
+//
+// Every timeslot pulls all active pins low with one port write, releases
+// them with another and samples all buses with one port read. So one slot
+// moves one bit on every bus: reading a scratchpad on each of two buses takes
+// the time of one read. Each bus gets its own bits in the slot, so bus 0 can
+// select sensor A while bus 1 selects sensor B.
+//
+// The pins should be on the same GPIO port (Photon: D2, D3, D4 = PB5, PB4,
+// PB3). Pins on another port still work but are switched one after the other
+// within the slot. The pins run open-drain: the 4.7K pull-up of each bus
+// keeps the line high, like the T-BUS on D3.
+//
+// Functions with a 'mask' work on the buses whose bit is set (bit 0 = first
+// pin). Buses outside the mask are left alone and see no slots at all.
+//
+// For serial work on one bus (search, setup) bus(b) is a normal OneWire:
+//    uint16_t pins[] = {D3, D2};
+//    OneWireMulti owm(pins, 2);
+//    owm.bus(1).search(addr);
+//
+// Parasite power is not supported: the sensors need their own supply.
+//
+// The bus health counters (OneWire::stats()) are kept per bus, lockstep
+// traffic included. Buses in lockstep share their slots, so their
+// irqOffMicros overlap: do not add them up (statsJSON() does not).
+class OneWireMulti
+{
+  public:
+    OneWireMulti(const uint16_t *pins, uint8_t count);
+
+    uint8_t count(void) const { return _count; }
+
+    // Mask with all buses
+    uint8_t all(void) const { return (1 << _count) - 1; }
+
+    // Bus b as a single OneWire (search(), select()... on that pin only).
+    OneWire &bus(uint8_t b) { return _bus[b]; }
+
+    // Reset cycle on the buses in 'mask'. Returns the mask of the buses
+    // where a device answered with a presence pulse.
+    uint8_t reset(uint8_t mask);
+
+    // One timeslot on the buses in 'mask'. Buses in 'ones' send a 1 (or
+    // read), the others send a 0. Returns the mask of the buses that read 1.
+    uint8_t touch(uint8_t mask, uint8_t ones);
+
+    // Write one byte per bus: v[b] for bus b.
+    void write(uint8_t mask, const uint8_t *v);
+
+    // Write the same byte on all buses in 'mask' (ex: Skip ROM, Convert T).
+    void write(uint8_t mask, uint8_t v);
+
+    // Read one byte per bus into v[b].
+    void read(uint8_t mask, uint8_t *v);
+
+    // Match ROM: roms[b] is the sensor to select on bus b.
+    void select(uint8_t mask, const uint8_t *const *roms);
+
+    // Like OneWire::read_scratchpad_checked() on every bus in 'mask' at once,
+    // after reset(), select() and the Read Scratchpad command. buf[b] gets
+    // the 'len' bytes of bus b, result[b] one of the ONEWIRE_READ_... results.
+    // A dead bus (see OneWire::deadBusBytes(), family[b] = family code of
+    // the sensor on bus b, or no table: unknown) leaves the lockstep early.
+    // Every bus that did not read OK ends with a reset(). Returns the mask
+    // of the buses that read OK.
+    uint8_t read_scratchpads(uint8_t mask, uint8_t (*buf)[9], uint8_t len, uint8_t *result, const uint8_t *family = 0);
+
+    // Release the buses in 'mask'.
+    void depower(uint8_t mask);
+
+#if ONEWIRE_STATS
+    // The counters of all buses as one OneWire::statsJSON(): added up,
+    // except "irq_us", the largest of the buses (their lockstep slots
+    // overlap), and the ROMs of every bus (up to ONEWIRE_STATS_ROMS).
+    int statsJSON(char *buf, size_t len) const;
+#endif
+
+  private:
+    // One bus seen as an ordinary OneWire
+    class Bus : public OneWire
+    {
+      friend class OneWireMulti;    // for the statistics hooks
+
+      public:
+        Bus(void) : OneWire(), _owner(0), _mask(0) {}
+        void attach(OneWireMulti *owner, uint8_t mask) { _owner = owner; _mask = mask; }
+
+        uint8_t reset(void) { return _owner->reset(_mask) ? 1 : 0; }
+        void write_bit(uint8_t v) { _owner->touch(_mask, (v & 1) ? _mask : 0); }
+        uint8_t read_bit(void) { return _owner->touch(_mask, _mask) ? 1 : 0; }
+        void depower(void) { _owner->depower(_mask); }
+
+      private:
+        OneWireMulti *_owner;
+        uint8_t _mask;
+    };
+
+    uint16_t _pins[ONEWIRE_MULTI_MAX_BUSES];
+    uint8_t _count;
+    Bus _bus[ONEWIRE_MULTI_MAX_BUSES];
+
+/**************Conditional port access for Photon*****************************/
+  #if PLATFORM_ID == 6 || PLATFORM_ID == 8 || PLATFORM_ID == 10  // Photon(P0),P1,Electron
+    GPIO_TypeDef *_port;                          // common port, 0 if the pins are spread
+    uint16_t _portMask[ONEWIRE_MULTI_MAX_BUSES];  // bit of each pin in the port
+
+    inline uint16_t portBits(uint8_t mask) {
+      uint16_t bits = 0;
+      for (uint8_t b = 0; b < _count; b++) {
+        if (mask & (1 << b)) bits |= _portMask[b];
+      }
+      return bits;
+    }
+
+    inline void driveLow(uint8_t mask) {
+      if (_port) { _port->BSRRH = portBits(mask); return; }
+      for (uint8_t b = 0; b < _count; b++) {
+        if (mask & (1 << b)) pinResetFast(_pins[b]);
+      }
+    }
+
+    inline void release(uint8_t mask) {
+      if (_port) { _port->BSRRL = portBits(mask); return; }
+      for (uint8_t b = 0; b < _count; b++) {
+        if (mask & (1 << b)) pinSetFast(_pins[b]);
+      }
+    }
+
+    inline uint8_t sample(void) {
+      uint8_t r = 0;
+      if (_port) {
+        uint16_t in = _port->IDR;
+        for (uint8_t b = 0; b < _count; b++) {
+          if (in & _portMask[b]) r |= 1 << b;
+        }
+        return r;
+      }
+      for (uint8_t b = 0; b < _count; b++) {
+        if (pinReadFast(_pins[b])) r |= 1 << b;
+      }
+      return r;
+    }
+
+  #else
+
+    inline void driveLow(uint8_t mask) {
+      for (uint8_t b = 0; b < _count; b++) {
+        if (mask & (1 << b)) pinResetFast(_pins[b]);
+      }
+    }
+
+    inline void release(uint8_t mask) {
+      for (uint8_t b = 0; b < _count; b++) {
+        if (mask & (1 << b)) pinSetFast(_pins[b]);
+      }
+    }
+
+    inline uint8_t sample(void) {
+      uint8_t r = 0;
+      for (uint8_t b = 0; b < _count; b++) {
+        if (pinReadFast(_pins[b])) r |= 1 << b;
+      }
+      return r;
+    }
+  #endif
+/**************End conditional port access for Photon*************************/
+};
+
+#endif // OneWireMulti_h
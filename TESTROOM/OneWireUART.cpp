@@ -0,0 +1,134 @@
+/*
+
+OneWireUART - 1-Wire bus over a half duplex USART (see OneWireUART.h).
+
+Uses the well known UART timeslot trick from Maxim Application Note 214
+"Using a UART to Implement a 1-Wire Bus Master".
+
+*/
+
+#include "OneWireUART.h"
+#include "application.h"
+
+OneWireUART::OneWireUART(USARTSerial &serial) : OneWire(), _serial(serial), _baud(0)
+{
+}
+
+void OneWireUART::setBaud(uint32_t baud)
+{
+    if (baud == _baud) return;
+
+    // begin() on a running USART only sets the new baud rate: no end(), which
+    // would release the TX pin and put a glitch on the bus
+    _serial.begin(baud);
+    _serial.halfduplex(true);    // TX pin open-drain, echo read back on TX
+
+    _baud = baud;
+}
+
+uint8_t OneWireUART::touch(const uint8_t *tx, uint8_t *rx, uint8_t count)
+{
+    // Allow 3 byte times per slot byte before giving up
+    uint32_t timeout = (uint32_t)count * 30000000UL / _baud + 1000;
+    uint32_t start;
+    uint8_t n = 0;
+
+    while (_serial.available()) _serial.read();    // drop stale echoes
+
+    _serial.write(tx, count);
+
+    start = micros();
+    while (n < count) {
+        if (_serial.available()) {
+            rx[n++] = _serial.read();
+        }
+        else if (micros() - start > timeout) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+//
+// Reset: a 0xF0 at 9600 baud holds the line low for ~520uS. A presence
+// pulse pulls some of the high bits low, so the echo differs from 0xF0.
+// An echo of 0x00 means the bus is shorted.
+//
+uint8_t OneWireUART::reset(void)
+{
+    uint8_t tx = 0xF0;
+    uint8_t rx;
+    uint8_t presence;
+
+    setBaud(ONEWIRE_UART_RESET_BAUD);
+
+    if (!touch(&tx, &rx, 1)) {
+        countReset(0, true);
+        return 0;
+    }
+
+    // Stays at 9600 baud: the next write/read switches back (a next reset() does not)
+
+    presence = rx != 0xF0 && rx != 0x00;
+    countReset(presence, rx == 0x00);    // nothing masks interrupts here: no countIrqOff()
+
+    return presence;
+}
+
+void OneWireUART::write_bit(uint8_t v)
+{
+    uint8_t tx = (v & 1) ? 0xFF : 0x00;
+    uint8_t rx;
+
+    setBaud(ONEWIRE_UART_DATA_BAUD);
+    countEcho(touch(&tx, &rx, 1) && rx == tx);
+}
+
+uint8_t OneWireUART::read_bit(void)
+{
+    uint8_t tx = 0xFF;
+    uint8_t rx;
+
+    setBaud(ONEWIRE_UART_DATA_BAUD);
+    if (!touch(&tx, &rx, 1)) return 1;    // nothing pulled the line low
+
+    return rx == 0xFF;
+}
+
+void OneWireUART::write(uint8_t v, uint8_t power /* = 0 */)
+{
+    uint8_t tx[8];
+    uint8_t rx[8];
+
+    for (uint8_t i = 0; i < 8; i++) {
+        tx[i] = (v & (1 << i)) ? 0xFF : 0x00;
+    }
+
+    setBaud(ONEWIRE_UART_DATA_BAUD);
+    countEcho(touch(tx, rx, 8) && memcmp(rx, tx, 8) == 0);    // one error per byte
+    countBytes(1);
+    if (power) countPower(false);    // no strong pull-up on an open-drain TX pin
+}
+
+uint8_t OneWireUART::read(void)
+{
+    uint8_t tx[8] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+    uint8_t rx[8];
+    uint8_t r = 0;
+
+    setBaud(ONEWIRE_UART_DATA_BAUD);
+    if (!touch(tx, rx, 8)) return 0xFF;
+    countBytes(1);
+
+    for (uint8_t i = 0; i < 8; i++) {
+        if (rx[i] == 0xFF) r |= 1 << i;
+    }
+
+    return r;
+}
+
+void OneWireUART::depower(void)
+{
+    // Open-drain TX: the bus is only ever pulled high by the resistor.
+}
@@ -0,0 +1,71 @@
+#ifndef OneWireUART_h
+#define OneWireUART_h
+
+#include <inttypes.h>
+#include "application.h"
+#include "OneWire.h"
+
+// Baud rates of the UART timeslot trick: one UART byte = one 1-Wire slot.
+#define ONEWIRE_UART_RESET_BAUD 9600
+#define ONEWIRE_UART_DATA_BAUD  115200
+
+// 1-Wire backend that drives the bus with a hardware USART instead of
+// bit-banging a GPIO pin with interrupts masked.
+//
+// The USART runs in half duplex mode: its TX pin is open-drain and is
+// connected to the 1-Wire data line (4.7K pull-up, like the T-BUS on D3).
+// Every timeslot is one UART byte, and the echo that comes back on the same
+// pin tells what the bus did:
+//   - reset: 0xF0 at 9600 baud. The echo changes if a device answers with
+//            a presence pulse. The USART stays at 9600 baud until the next
+//            slot needs 115200: one baud switch per reset, none between
+//            resets (bind() checks every slot with its own reset).
+//   - write: 0xFF (short low pulse = 1) or 0x00 (long low pulse = 0) at
+//            115200 baud. The echo must be the byte sent: anything else is
+//            another driver on the line (contention) or a short, counted
+//            in stats().echoErrors.
+//   - read:  0xFF at 115200 baud. The echo is 0xFF only if no device held
+//            the line low, so it reads as a 1.
+// The timing is done by the USART, so nothing runs with interrupts off
+// and the WiFi stack is never held up by the T-BUS.
+//
+// It has the same API as OneWire, so a sketch picks the backend per bus:
+//    OneWire ds = OneWire(D3);     // GPIO bit-banging
+//    OneWireUART ds(Serial1);      // TX pin, no interrupts masked
+//
+// Externally powered sensors only (VDD on 3V3, 3 wires). The open-drain TX
+// pin cannot drive the strong pull-up a parasite powered DS18B20 needs
+// during Convert T or Copy Scratchpad: such a sensor answers, but converts
+// garbage. A write() with 'power' = 1 sends the byte without the pull-up
+// and is counted in stats().powerErrors ("nopow" in statsJSON()), so a
+// parasite sensor on a UART bus shows up in TBUS_health.
+class OneWireUART : public OneWire
+{
+  public:
+    OneWireUART(USARTSerial &serial);
+
+    uint8_t reset(void);
+    void write_bit(uint8_t v);
+    uint8_t read_bit(void);
+
+    // A byte is sent as 8 timeslot bytes in one go, then the 8 echoes are
+    // collected, so the USART streams the whole byte without gaps.
+    // 'power' = 1 cannot be honoured: counted as a power error.
+    void write(uint8_t v, uint8_t power = 0);
+    uint8_t read(void);
+
+    void depower(void);
+
+  private:
+    USARTSerial &_serial;
+    uint32_t _baud;
+
+    // Switch the USART to 'baud' if it is not there yet.
+    void setBaud(uint32_t baud);
+
+    // Send 'count' timeslot bytes and read back their echoes into 'rx'.
+    // Returns 0 if the echoes did not arrive in time (no wiring / no pull-up).
+    uint8_t touch(const uint8_t *tx, uint8_t *rx, uint8_t count);
+};
+
+#endif // OneWireUART_h
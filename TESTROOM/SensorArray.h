@@ -0,0 +1,196 @@
+#ifndef SensorArray_h
+#define SensorArray_h
+
+#include <inttypes.h>
+#include "application.h"
+#include "TBus.h"
+
+// The readings of a fixed set of T-BUS sensors, one array per field.
+//
+// Replaces the named doubles + "double* temps[]" pointer table and the
+// parallel crcErrorCount[] / tmStamp[] arrays of the sketches. N is the
+// number of sensors, known at compile time: the ROM table must have exactly
+// N entries (addrs0[12][8] for a SensorArray<12>, or it does not compile)
+// and every loop runs to N.
+//
+// Readings are kept in centi-degrees (see FixedPoint.h): celsius(i) gives
+// the double for a JSON or a "double" Particle.variable.
+//
+// Filter: every sensor keeps its last H good readings in a ring buffer.
+// filtered[i] is their median, so a single spike (a bit error the CRC let
+// through, the 85 °C power-up value of a sensor that just came back) never
+// reaches the calculations, while a real step passes after H/2 + 1 cycles.
+// average(i) is the moving average of the same readings. Readings outside
+// setLimits() are rejected like a CRC error. The work per reading is fixed
+// (H values), whatever N.
+//
+//    byte addrs0[12][8] = {...};              // seed, see TBus::bind()
+//    SensorArray<12> boilers(addrs0);         // H = 5 (or SensorArray<12, 3>)
+//    centi_t &KSTopH = boilers.filtered[0];   // named accessors
+//    TBus tbus(ds, boilers.rom, boilers.count);
+//
+//    if (tbus.poll()) {
+//      for (int i = 0; i < boilers.count; i++) {
+//        if (!boilers.update(i, tbus, Time.now())) ... bad reading ...
+//      }
+//    }
+template <uint8_t N, uint8_t H = 5>
+class SensorArray
+{
+    static_assert(H >= 1 && H <= 15 && (H & 1), "SensorArray: H (readings in the filter) must be odd, 1..15");
+
+  public:
+    static const uint8_t count = N;
+    static const uint8_t history = H;    // readings per sensor in the filter (1..15, odd)
+
+    uint8_t rom[N][8];       // ROM IDs, the table TBus binds to EEPROM
+    int16_t raw[N];          // temperature register of the last good reading
+    centi_t centi[N];        // last good reading (1/100 °C)
+    centi_t filtered[N];     // median of the last H good readings: use this one
+    uint16_t errors[N];      // bad readings: CRC error, no answer or out of limits
+    uint32_t lastGood[N];    // Time.now() of the last good reading
+
+    SensorArray(const uint8_t (&roms)[N][8])
+    {
+        memcpy(rom, roms, sizeof(rom));
+        for (uint8_t i = 0; i < N; i++) {
+            raw[i] = 0;
+            centi[i] = 0;
+            filtered[i] = 0;
+            errors[i] = 0;
+            lastGood[i] = 0;
+            _head[i] = 0;
+            _fill[i] = 0;
+            _sum[i] = 0;
+        }
+        _errorsChanged = true;    // first updateErrorJSON() fills the buffer
+        _min = CENTI(-55);        // DS18B20 range
+        _max = CENTI(125);
+    }
+
+    // Plausibility limits: readings outside [min, max] are rejected (ex: a
+    // boiler between 1 and 99 °C).
+    void setLimits(centi_t min, centi_t max)
+    {
+        _min = min;
+        _max = max;
+    }
+
+    // Start the timeout clocks (setup(), once Time is valid): a bad first
+    // reading after start-up is then not reported as a timeout.
+    void begin(uint32_t now)
+    {
+        for (uint8_t i = 0; i < N; i++) lastGood[i] = now;
+    }
+
+    // Take the reading of sensor i from the last tbus.poll(). A bad reading
+    // (CRC error, no answer, out of limits) is counted and leaves the last
+    // good one in place. Returns true if the reading was good.
+    // A sensor the last poll() did not read (alarm polling, see
+    // TBus::fresh()) is left alone: no error, no copy of its old reading in
+    // the filter. Returns true for it.
+    bool update(uint8_t i, const TBus &tbus, uint32_t now)
+    {
+        centi_t c;
+
+        if (i >= N) return false;
+        if (!tbus.fresh(i)) return true;
+
+        c = tbus.centi(i);
+        if (!tbus.valid(i) || c < _min || c > _max) {
+            if (errors[i] < 0xFFFF) { errors[i]++; _errorsChanged = true; }
+            return false;
+        }
+
+        raw[i] = tbus.raw(i);
+        centi[i] = c;
+        lastGood[i] = now;
+
+        // Ring buffer: the oldest reading leaves the running sum
+        if (_fill[i] == H) _sum[i] -= _history[i][_head[i]];
+        else _fill[i]++;
+        _history[i][_head[i]] = c;
+        _sum[i] += c;
+        if (++_head[i] == H) _head[i] = 0;
+
+        filtered[i] = median(i);
+
+        return true;
+    }
+
+    // Filtered reading of sensor i in °C (for publishing only).
+    double celsius(uint8_t i) const
+    {
+        return centiToDouble(filtered[i]);
+    }
+
+    // Moving average of the last H good readings of sensor i.
+    centi_t average(uint8_t i) const
+    {
+        return _fill[i] ? (centi_t)(_sum[i] / _fill[i]) : 0;
+    }
+
+    // Seconds since the last good reading of sensor i.
+    uint32_t age(uint8_t i, uint32_t now) const
+    {
+        return now - lastGood[i];
+    }
+
+    // The error counts as JSON: {"errorCount":[17,4,4,14,8,3]} => 17 = sensor 0...
+    // Returns the length (truncated to fit 'len').
+    int errorJSON(char *buf, size_t len) const
+    {
+        size_t n;
+
+        if (len == 0) return 0;
+
+        n = snprintf(buf, len, "{\"errorCount\":[");
+        for (uint8_t i = 0; i < N && n < len; i++) {
+            n += snprintf(buf + n, len - n, i ? ",%u" : "%u", errors[i]);
+        }
+        if (n < len) n += snprintf(buf + n, len - n, "]}");
+
+        return n < len ? n : len - 1;
+    }
+
+    // Rewrite the errorJSON() in 'buf' only if a count changed since the last
+    // call: a cycle without bad readings costs nothing. Returns true if 'buf'
+    // was rewritten. Use one buffer per SensorArray.
+    bool updateErrorJSON(char *buf, size_t len)
+    {
+        if (!_errorsChanged) return false;
+
+        errorJSON(buf, len);
+        _errorsChanged = false;
+
+        return true;
+    }
+
+  private:
+    centi_t _history[N][H];  // last H good readings per sensor
+    uint8_t _head[N];        // next slot in _history[i]
+    uint8_t _fill[N];        // readings in _history[i] (H once full)
+    int32_t _sum[N];         // sum of _history[i], for average()
+    centi_t _min, _max;
+    bool _errorsChanged;
+
+    // Median of the readings in _history[i]: insertion sort of a copy (H
+    // values, so a fixed cost).
+    centi_t median(uint8_t i) const
+    {
+        centi_t v[H];
+        uint8_t n = _fill[i];
+
+        for (uint8_t j = 0; j < n; j++) {
+            centi_t x = _history[i][j];
+            uint8_t k = j;
+
+            while (k > 0 && v[k - 1] > x) { v[k] = v[k - 1]; k--; }
+            v[k] = x;
+        }
+
+        return (n & 1) ? v[n / 2] : (centi_t)(((int32_t)v[n / 2 - 1] + v[n / 2]) / 2);
+    }
+};
+
+#endif // SensorArray_h
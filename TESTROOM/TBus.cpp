@@ -0,0 +1,578 @@
+/*
+
+TBus - Non-blocking reader for the DS18B20 sensors on a PhotoniX T-BUS (D3).
+
+Replaces the "ds.write(0x44) + delay(1000)" sequence that every getTemperatures()
+used: the conversion is started, loop() keeps running, and the scratchpads are
+collected by poll() once the conversion time has passed.
+Based on the two-step getTemperatures() in S-ECO_SOLAR (3nov25).
+
+*/
+
+#include "TBus.h"
+#include "application.h"
+
+TBus::TBus(OneWire &ow, uint8_t (*roms)[8], uint8_t count)
+    : _ds(ow), _multi(0), _busOf(0), _roms(roms), _count(count), _seedCrc(0), _eepromAddress(-1), _rebound(0), _missing(0),
+      _fresh(0), _powerUp(0), _converting(false), _conversionStart(0), _conversionMs(TBUS_CONVERSION_MS),
+      _periodMs(0), _cycleStart(0), _cycling(false),
+      _alarmMargin(0), _sweepEvery(1), _sweepCount(0)
+{
+    if (_count > TBUS_MAX_SENSORS) _count = TBUS_MAX_SENSORS;
+
+    // Fingerprint of the compiled table, before bind() overwrites it
+    _seedCrc = OneWire::crc16(&roms[0][0], 8 * _count);
+
+    for (uint8_t i = 0; i < TBUS_MAX_SENSORS; i++) {
+        _raw[i] = 0;
+        _valid[i] = false;
+        _bits[i] = 12;    // power-up default of the DS18B20
+    }
+}
+
+TBus::TBus(OneWireMulti &owm, uint8_t (*roms)[8], const uint8_t *busOf, uint8_t count)
+    : TBus(owm.bus(0), roms, count)
+{
+    _multi = &owm;
+    _busOf = busOf;
+}
+
+uint8_t TBus::startConversion(void)
+{
+    if (_multi) {
+        uint8_t present = _multi->reset(_multi->all());
+        if (!present) return 0;
+
+        _multi->write(present, 0xCC);    // Skip ROM + Convert T on all buses at once
+        _multi->write(present, 0x44);
+    }
+    else {
+        if (!_ds.reset()) return 0;
+
+        _ds.skip();
+        _ds.write(0x44, 0);    // Convert T on all sensors at once
+    }
+
+    _conversionStart = millis();
+    _converting = true;
+
+    return 1;
+}
+
+uint8_t TBus::poll(void)
+{
+    uint8_t addr[8];
+    uint32_t all = (_count < 32) ? (1UL << _count) - 1 : 0xFFFFFFFF;
+    uint32_t failed = 0;    // slots whose last read failed
+    uint32_t ok;
+    bool sweep;
+
+    if (_periodMs) {
+        // Pipelined: one cycle per period. The conversion of the previous
+        // cycle is done by now: read it first, then start the next one.
+        if (_cycling && millis() - _cycleStart < _periodMs) return 0;
+        if (_converting && millis() - _conversionStart < _conversionMs) return 0;
+
+        _cycleStart = millis();
+        _cycling = true;
+
+        if (!_converting) {
+            // First cycle, or no answer last time: nothing to read yet. Read
+            // this conversion as soon as it is done instead of a period later.
+            if (startConversion() && _periodMs > _conversionMs) _cycleStart -= _periodMs - _conversionMs;
+            return 0;
+        }
+    }
+    else {
+        if (!_converting) return 0;
+        if (millis() - _conversionStart < _conversionMs) return 0;
+    }
+
+    _converting = false;
+
+    for (uint8_t i = 0; i < _count; i++) {
+        if (!_valid[i]) failed |= 1UL << i;
+    }
+
+    sweep = (_alarmMargin == 0) || (_sweepCount == 0);
+    if (_alarmMargin) {
+        if (++_sweepCount >= _sweepEvery) _sweepCount = 0;
+    }
+
+    if (sweep) {
+        _fresh = all;
+        ok = readSensors(_fresh);
+    }
+    else {
+        // Alarm cycle: collect the alarmed ROMs first, the conditional search
+        // must not be interleaved with other bus traffic. Slots whose last
+        // read failed are read again: no alarm band is armed for them, and
+        // a sensor that came back must not wait for the next sweep.
+        uint32_t alarmed = failed;
+
+        for (uint8_t b = 0; b < (_multi ? _multi->count() : 1); b++) {
+            OneWire &ds = _multi ? _multi->bus(b) : _ds;
+
+            ds.reset_search();
+            while (ds.search(addr, false)) {
+                int i = slotOf(addr);
+                if (i >= 0) alarmed |= 1UL << i;
+            }
+            ds.reset_search();
+        }
+
+        _fresh = alarmed;
+        ok = readSensors(alarmed);
+    }
+
+    // A sensor that just came back was not there for the Convert T: it
+    // still holds its 85 °C power-up value. Drop that reading once, the
+    // sensor is read again next cycle (a real 85 °C passes then).
+    for (uint8_t i = 0; i < _count; i++) {
+        uint32_t bit = 1UL << i;
+
+        if (!(ok & bit)) continue;
+
+        if ((failed & bit) && !(_powerUp & bit) && _raw[i] == ((_roms[i][0] == 0x10) ? 0x00AA : 0x0550)) {
+            _powerUp |= bit;
+            _valid[i] = false;
+            _fresh &= ~bit;
+            ok &= ~bit;
+        }
+        else _powerUp &= ~bit;
+    }
+
+    if (_alarmMargin) {
+        for (uint8_t i = 0; i < _count; i++) {
+            if (ok & (1UL << i)) armAlarm(i);
+        }
+    }
+
+    if (_periodMs) startConversion();    // the next reading converts while the sketch uses this one
+
+    return 1;
+}
+
+void TBus::setPipelined(uint32_t periodMs)
+{
+    _periodMs = periodMs;
+    _cycling = false;    // first cycle on the next poll()
+}
+
+bool TBus::readSensor(uint8_t i)
+{
+    uint8_t data[9];
+
+    _valid[i] = readScratchpad(i, data);
+    if (_valid[i]) decode(i, data);
+
+    return _valid[i];
+}
+
+uint32_t TBus::readSensors(uint32_t slots)
+{
+    uint32_t ok = 0;
+
+    if (!_multi) {
+        for (uint8_t i = 0; i < _count; i++) {
+            if ((slots & (1UL << i)) && readSensor(i)) ok |= 1UL << i;
+        }
+        return ok;
+    }
+
+    // Rounds of at most one sensor per bus
+    while (slots) {
+        uint8_t slot[ONEWIRE_MULTI_MAX_BUSES];
+        const uint8_t *roms[ONEWIRE_MULTI_MAX_BUSES];
+        uint8_t family[ONEWIRE_MULTI_MAX_BUSES];
+        uint8_t data[ONEWIRE_MULTI_MAX_BUSES][9];
+        uint8_t result[ONEWIRE_MULTI_MAX_BUSES];
+        uint8_t mask = 0;
+        uint8_t present, read = 0;
+
+        for (uint8_t i = 0; i < _count; i++) {
+            uint8_t b = _busOf[i];
+
+            if (!(slots & (1UL << i))) continue;
+            if (b >= _multi->count()) { _valid[i] = false; slots &= ~(1UL << i); continue; }
+            if (mask & (1 << b)) continue;    // bus already busy in this round
+
+            slot[b] = i;
+            roms[b] = _roms[i];
+            family[b] = _roms[i][0];
+            mask |= 1 << b;
+            slots &= ~(1UL << i);
+        }
+        if (!mask) break;
+
+        present = _multi->reset(mask);
+        if (present) {
+            _multi->select(present, roms);
+            _multi->write(present, 0xBE);    // Read Scratchpad
+            read = _multi->read_scratchpads(present, data, 9, result, family);
+        }
+
+        for (uint8_t b = 0; b < _multi->count(); b++) {
+            if (!(mask & (1 << b))) continue;
+
+            _valid[slot[b]] = read & (1 << b);
+            if (!_valid[slot[b]]) continue;
+
+            decode(slot[b], data[b]);
+            ok |= 1UL << slot[b];
+        }
+    }
+
+    return ok;
+}
+
+void TBus::decode(uint8_t i, const uint8_t *data)
+{
+    if (_roms[i][0] == 0x10)
+        _raw[i] = data[0];    // DS18S20: 0.5 °C per LSB
+    else {
+        // Below 12 bit the lowest bits are undefined: clear them, using the
+        // resolution the sensor reports in its config byte.
+        uint8_t undefinedBits = 3 - ((data[4] >> 5) & 0x03);
+        _raw[i] = (int16_t)((data[1] << 8) | data[0]) & ~((1 << undefinedBits) - 1);
+    }
+}
+
+void TBus::setAlarmPolling(uint8_t margin, uint8_t sweepEvery)
+{
+    _alarmMargin = margin;
+    _sweepEvery = sweepEvery ? sweepEvery : 1;
+    _sweepCount = 0;    // next conversion is a full sweep, which arms all bands
+}
+
+void TBus::armAlarm(uint8_t i)
+{
+    // Whole degrees, rounded down (-0.5 °C -> -1) by the arithmetic shift
+    // of GCC: no soft-float floor() on the Photon
+    int16_t t = (_roms[i][0] == 0x10) ? (_raw[i] >> 1) : (_raw[i] >> 4);
+    int16_t th = t + _alarmMargin;
+    int16_t tl = t - _alarmMargin;
+
+    if (th > 125) th = 125;
+    if (tl < -55) tl = -55;
+
+    setAlarm(i, th, tl);
+}
+
+uint8_t TBus::setAlarm(uint8_t i, int8_t th, int8_t tl)
+{
+    if (i >= _count) return 0;
+    if (!wire(i).reset()) return 0;
+
+    writeScratchpad(i, (uint8_t)th, (uint8_t)tl, ((_bits[i] - 9) << 5) | 0x1F);
+
+    return 1;
+}
+
+int TBus::slotOf(const uint8_t *rom) const
+{
+    for (uint8_t i = 0; i < _count; i++) {
+        if (memcmp(_roms[i], rom, 8) == 0) return i;
+    }
+
+    return -1;
+}
+
+uint16_t TBus::conversionTime(uint8_t bits)
+{
+    if (bits < 9) bits = 9;
+    if (bits > 12) bits = 12;
+
+    // 93.75 ms at 9 bit, doubling per extra bit. Rounded up.
+    return (TBUS_CONVERSION_MS + (1 << (12 - bits)) - 1) >> (12 - bits);
+}
+
+uint8_t TBus::setResolution(uint8_t i, uint8_t bits)
+{
+    uint8_t data[9];
+
+    if (i >= _count) return 0;
+    if (_roms[i][0] == 0x10) return 0;    // DS18S20: fixed 9 bit, no config register
+
+    if (bits < 9) bits = 9;
+    if (bits > 12) bits = 12;
+
+    // Read first so the TH/TL alarm bytes are written back unchanged
+    if (!readScratchpad(i, data)) return 0;
+
+    // Already set (and in its EEPROM, see below): no EEPROM write at every boot
+    if (((data[4] >> 5) & 0x03) != bits - 9) {
+        OneWire &ds = wire(i);
+
+        ds.reset();
+        writeScratchpad(i, data[2], data[3], ((bits - 9) << 5) | 0x1F);    // R1 R0 in bits 6:5
+
+        // Copy Scratchpad: the sensor reloads its config from EEPROM at power-up.
+        // Without it a power-cycled sensor converts at 12 bit again, while
+        // poll() only waits the shorter conversion time: truncated readings.
+        ds.reset();
+        ds.select(_roms[i]);
+        ds.write(0x48, 1);    // bus held high: parasite powered sensors need it for the EEPROM write
+        delay(10);            // EEPROM write time (datasheet: 10 ms max)
+        ds.depower();
+    }
+
+    _bits[i] = bits;
+    updateConversionTime();
+
+    return 1;
+}
+
+void TBus::writeScratchpad(uint8_t i, uint8_t th, uint8_t tl, uint8_t config)
+{
+    OneWire &ds = wire(i);
+
+    ds.select(_roms[i]);
+    ds.write(0x4E);    // Write Scratchpad: TH, TL, config
+    ds.write(th);
+    ds.write(tl);
+    if (_roms[i][0] != 0x10) ds.write(config);    // DS18S20 has no config register
+}
+
+void TBus::updateConversionTime(void)
+{
+    // Wait only as long as the slowest sensor needs
+    _conversionMs = 0;
+    for (uint8_t j = 0; j < _count; j++) {
+        uint16_t ms = (_roms[j][0] == 0x10) ? TBUS_CONVERSION_MS : conversionTime(_bits[j]);
+        if (ms > _conversionMs) _conversionMs = ms;
+    }
+}
+
+uint8_t TBus::setResolution(const uint8_t *bits)
+{
+    uint8_t n = 0;
+
+    for (uint8_t i = 0; i < _count; i++) n += setResolution(i, bits[i]);
+
+    return n;
+}
+
+uint8_t TBus::bind(int eepromAddress)
+{
+    uint8_t data[9];
+    bool stored;
+
+    _eepromAddress = eepromAddress;
+    stored = loadRoms();
+
+    // One pass over the known ROMs instead of a full search
+    _rebound = 0;
+    _missing = 0;
+    for (uint8_t i = 0; i < _count; i++) {
+        if (!readScratchpad(i, data)) _missing |= 1UL << i;
+    }
+
+    if (_missing) rebind();
+
+    if (!stored || _rebound) saveRoms();
+
+    return __builtin_popcount(_rebound);
+}
+
+uint8_t TBus::scan(void)
+{
+    _rebound = 0;
+    _missing = (_count < 32) ? (1UL << _count) - 1 : 0xFFFFFFFF;
+
+    rebind();
+
+    if (_rebound && _eepromAddress >= 0) saveRoms();
+
+    return __builtin_popcount(_rebound);
+}
+
+void TBus::rebind(void)
+{
+    uint8_t found[TBUS_MAX_SENSORS][8];
+    uint8_t foundBus[TBUS_MAX_SENSORS];
+    uint8_t nFound = 0;
+    uint32_t used = 0;
+    uint8_t addr[8];
+
+    for (uint8_t b = 0; b < (_multi ? _multi->count() : 1); b++) {
+        OneWire &ds = _multi ? _multi->bus(b) : _ds;
+
+        ds.reset_search();
+        while (nFound < TBUS_MAX_SENSORS && ds.search(addr)) {
+            if (OneWire::crc8(addr, 7) != addr[7]) continue;
+            if (addr[0] != 0x28 && addr[0] != 0x10) continue;    // DS18B20 / DS18S20 only
+            foundBus[nFound] = b;
+            memcpy(found[nFound++], addr, 8);
+        }
+        ds.reset_search();
+    }
+
+    // Known ROMs keep their slot...
+    for (uint8_t i = 0; i < _count; i++) {
+        for (uint8_t j = 0; j < nFound; j++) {
+            if (!(used & (1UL << j)) && memcmp(_roms[i], found[j], 8) == 0) {
+                used |= 1UL << j;
+                _missing &= ~(1UL << i);
+                break;
+            }
+        }
+    }
+
+    // ...and unknown ones fill the slots that did not answer, in search order
+    for (uint8_t i = 0; i < _count; i++) {
+        if (!(_missing & (1UL << i))) continue;
+
+        for (uint8_t j = 0; j < nFound; j++) {
+            if (used & (1UL << j)) continue;
+            if (_multi && foundBus[j] != _busOf[i]) continue;    // a slot stays on its own bus
+
+            memcpy(_roms[i], found[j], 8);
+            used |= 1UL << j;
+            _missing &= ~(1UL << i);
+            _rebound |= 1UL << i;
+            break;
+        }
+    }
+
+    // A new sensor starts at its power-up 12 bit: give it the resolution of its slot
+    for (uint8_t i = 0; i < _count; i++) {
+        if ((_rebound & (1UL << i)) && _bits[i] != 12) setResolution(i, _bits[i]);
+    }
+}
+
+bool TBus::loadRoms(void)
+{
+    uint8_t head[4];
+    uint8_t rom[8];
+    uint16_t crc;
+    int a = _eepromAddress;
+
+    for (uint8_t k = 0; k < 4; k++) head[k] = EEPROM.read(a + k);
+
+    if (head[0] != TBUS_EEPROM_MARKER) return false;
+    if (head[1] != _count) return false;    // sensor count changed in the sketch
+    if ((head[2] | (head[3] << 8)) != _seedCrc) return false;    // addrs0 edited in the sketch: re-seed
+
+    crc = OneWire::crc16(head, 4);
+    for (uint8_t i = 0; i < _count; i++) {
+        for (uint8_t k = 0; k < 8; k++) rom[k] = EEPROM.read(a + 4 + 8 * i + k);
+        crc = OneWire::crc16(rom, 8, crc);
+    }
+    if (crc != (EEPROM.read(a + 4 + 8 * _count) | (EEPROM.read(a + 5 + 8 * _count) << 8))) return false;
+
+    for (uint8_t i = 0; i < _count; i++) {
+        for (uint8_t k = 0; k < 8; k++) _roms[i][k] = EEPROM.read(a + 4 + 8 * i + k);
+    }
+
+    return true;
+}
+
+void TBus::saveRoms(void)
+{
+    uint8_t head[4] = { TBUS_EEPROM_MARKER, _count, (uint8_t)_seedCrc, (uint8_t)(_seedCrc >> 8) };
+    uint16_t crc;
+    int a = _eepromAddress;
+
+    for (uint8_t k = 0; k < 4; k++) EEPROM.write(a + k, head[k]);
+
+    crc = OneWire::crc16(head, 4);
+    for (uint8_t i = 0; i < _count; i++) {
+        for (uint8_t k = 0; k < 8; k++) EEPROM.write(a + 4 + 8 * i + k, _roms[i][k]);
+        crc = OneWire::crc16(_roms[i], 8, crc);
+    }
+    EEPROM.write(a + 4 + 8 * _count, crc & 0xFF);
+    EEPROM.write(a + 5 + 8 * _count, crc >> 8);
+}
+
+int TBus::romJSON(char *buf, size_t len) const
+{
+    size_t n = 0;
+    bool first;
+
+    if (len == 0) return 0;
+    buf[0] = 0;
+
+// Append with snprintf, stop writing once the buffer is full
+#define TBUS_APPEND(...) \
+    if (n < len) { int w = snprintf(buf + n, len - n, __VA_ARGS__); if (w > 0) n += w; }
+
+    TBUS_APPEND("{\"roms\":[");
+    for (uint8_t i = 0; i < _count; i++) {
+        const uint8_t *r = _roms[i];
+        TBUS_APPEND("%s\"%02X%02X%02X%02X%02X%02X%02X%02X\"", i ? "," : "",
+                    r[0], r[1], r[2], r[3], r[4], r[5], r[6], r[7]);
+    }
+
+    TBUS_APPEND("],\"new\":[");
+    first = true;
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_rebound & (1UL << i)) { TBUS_APPEND("%s%d", first ? "" : ",", i); first = false; }
+    }
+
+    TBUS_APPEND("],\"miss\":[");
+    first = true;
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_missing & (1UL << i)) { TBUS_APPEND("%s%d", first ? "" : ",", i); first = false; }
+    }
+
+    TBUS_APPEND("]}");
+#undef TBUS_APPEND
+
+    return n < len ? n : len - 1;
+}
+
+bool TBus::readScratchpad(uint8_t i, uint8_t *data)
+{
+    OneWire &ds = wire(i);
+
+    if (!ds.reset()) return false;
+
+    ds.select(_roms[i]);
+    ds.write(0xBE, 0);    // Read Scratchpad
+
+    // CRC checked on the fly, a missing or shorted sensor aborts early (5 bytes, 8 for 0xFF on a DS18S20)
+    return ds.read_scratchpad_checked(data, 9, _roms[i][0]) == ONEWIRE_READ_OK;
+}
+
+bool TBus::valid(uint8_t i) const
+{
+    return i < _count && _valid[i];
+}
+
+bool TBus::fresh(uint8_t i) const
+{
+    return i < _count && (_fresh & (1UL << i));
+}
+
+int16_t TBus::raw(uint8_t i) const
+{
+    return i < _count ? _raw[i] : 0;
+}
+
+double TBus::celsius(uint8_t i) const
+{
+    if (i >= _count) return 0;
+
+    if (_roms[i][0] == 0x10) return (double)_raw[i] * 0.5;
+
+    return (double)_raw[i] * 0.0625;
+}
+
+centi_t TBus::centi(uint8_t i) const
+{
+    if (i >= _count) return 0;
+
+    if (_roms[i][0] == 0x10) return raw9ToCenti(_raw[i]);
+
+    return rawToCenti(_raw[i]);
+}
+
+#if ONEWIRE_STATS
+int TBus::statsJSON(char *buf, size_t len) const
+{
+    if (_multi) return _multi->statsJSON(buf, len);
+
+    return _ds.statsJSON(buf, len);
+}
+#endif
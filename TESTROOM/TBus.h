@@ -0,0 +1,222 @@
+#ifndef TBus_h
+#define TBus_h
+
+#include <inttypes.h>
+#include "application.h"
+#include "OneWire.h"
+#include "OneWireMulti.h"
+#include "FixedPoint.h"
+
+// Maximum number of sensors one T-BUS reader keeps readings for.
+// S-HVAC uses 12, the room controllers 1. Raise it for a 24-sensor layout.
+#ifndef TBUS_MAX_SENSORS
+#define TBUS_MAX_SENSORS 24    // max 32: slots are kept as bits in a uint32_t
+#endif
+
+// DS18B20 12-bit conversion time from the datasheet (ms).
+// Each bit less halves it: 11 bit = 375, 10 bit = 188, 9 bit = 94 ms.
+#define TBUS_CONVERSION_MS 750
+
+// EEPROM record of the ROM table (auto-binding): marker, count, CRC16 of
+// the compiled addrs0 table, ROMs, CRC16 of the record. Little endian.
+#define TBUS_EEPROM_MARKER 0xB6
+#define TBUS_EEPROM_SIZE(count) (6 + 8 * (count))
+
+// Non-blocking DS18B20/DS18S20 reader for a T-BUS (one OneWire pin).
+//
+// The old getTemperatures() did "Convert T", then delay(1000), then read all
+// scratchpads. This class splits that in two steps so loop() keeps running
+// while the sensors convert:
+//
+//    if (interval passed && !tbus.busy()) tbus.startConversion();
+//    if (tbus.poll()) { ... use tbus.valid(i) / tbus.celsius(i) ... }
+//
+// poll() returns 1 exactly once per conversion, after all scratchpads have
+// been collected and CRC checked.
+//
+// Pipelined: with setPipelined(period) poll() runs the bus by itself and the
+// sketch only calls poll(). Each cycle reads the conversion of the previous
+// one and starts the next Convert T right after, so the readings are there
+// the moment poll() returns 1: no conversion wait in front of SetHeating().
+//
+// Auto-binding: with bind() the ROM table lives in EEPROM, so a replaced
+// sensor is picked up without reflashing. The compiled addrs0 table is only
+// the seed: it is used at the first boot and again whenever it is edited in
+// the sketch (the record keeps a CRC of the seed it came from). The slot number (index in addrs0) keeps
+// its meaning: slot 0 stays KSTopH, even after its sensor was replaced.
+//
+// Multi-bus: with a OneWireMulti the sensors are spread over several pins
+// ('busOf' gives the bus of each slot). Conversion and scratchpad reads run
+// on all buses in lockstep, so two buses of 6 sensors take the bus time of
+// one bus of 6. A replaced sensor only takes a free slot of its own bus.
+class TBus
+{
+  public:
+    // 'roms' is the sketch's addrs0 table, 'count' the number of sensors in it.
+    // With bind() the table is overwritten with the ROMs stored in EEPROM.
+    TBus(OneWire &ow, uint8_t (*roms)[8], uint8_t count);
+
+    // Multi-bus: 'busOf' has the bus number (OneWireMulti pin index) of
+    // every slot in 'roms'.
+    TBus(OneWireMulti &owm, uint8_t (*roms)[8], const uint8_t *busOf, uint8_t count);
+
+    // Load the ROM table from EEPROM at 'eepromAddress' (TBUS_EEPROM_SIZE
+    // bytes) and check every slot with one scratchpad read. Only if a slot
+    // does not answer, the bus is searched and unknown sensors take the free
+    // slots (ex: the TOP-H replacement of 28oct19). A record written for
+    // another addrs0 (edited and reflashed) or with a bad CRC is ignored:
+    // the compiled table is used. The table is saved back when it changed. Returns the number of rebound slots.
+    uint8_t bind(int eepromAddress);
+
+    // Full search of the bus, like bind() after a sensor was swapped.
+    // Returns the number of rebound slots.
+    uint8_t scan(void);
+
+    // The ROM table as one compact JSON for a single publish:
+    //   {"roms":["28DBB503000080BB",...],"new":[0],"miss":[7]}
+    // "new" = slots rebound by the last bind()/scan(), "miss" = slots
+    // without a sensor. Returns the length (truncated to fit 'len').
+    int romJSON(char *buf, size_t len) const;
+
+    // Broadcast a Convert T (skip ROM) to all sensors and return immediately.
+    // Returns 0 if no device answered the reset pulse.
+    uint8_t startConversion(void);
+
+    // Call this every loop(). Returns 1 once the conversion time has passed
+    // and the scratchpads of all sensors have been read.
+    uint8_t poll(void);
+
+    // True from startConversion() until poll() has collected the readings.
+    // Always true in pipelined mode: there is a conversion in the background.
+    bool busy(void) const { return _converting; }
+
+    // Pipelined mode: every 'periodMs' poll() reads the scratchpads of the
+    // conversion started one period earlier and immediately starts the next
+    // Convert T. The readings are then at most one period old and poll()
+    // returns 1 without a conversion wait. Do not call startConversion()
+    // yourself. The period should be longer than conversionTime(): a cycle
+    // never reads before the conversion is done. 0 = off (manual mode).
+    void setPipelined(uint32_t periodMs);
+    bool pipelined(void) const { return _periodMs != 0; }
+
+    uint8_t count(void) const { return _count; }
+
+    // Write the configuration register of sensor i for a 9, 10, 11 or 12 bit
+    // resolution (TH/TL alarm bytes are kept) and copy it to the sensor's
+    // EEPROM, so it survives a power cycle of the sensor. A sensor that is
+    // already at 'bits' is left alone (no EEPROM write at every boot).
+    // DS18S20 sensors are skipped. Returns 0 if the sensor did not answer.
+    uint8_t setResolution(uint8_t i, uint8_t bits);
+
+    // Same, from a table with one entry per ROM in addrs0 (ex: resolution0[]).
+    // Returns the number of sensors that were configured.
+    uint8_t setResolution(const uint8_t *bits);
+
+    // Program the TH/TL alarm registers of sensor i (°C, integer part only).
+    // The sensor raises its alarm flag after a conversion at or above TH or
+    // at or below TL. Returns 0 if the sensor did not answer.
+    uint8_t setAlarm(uint8_t i, int8_t th, int8_t tl);
+
+    // Alarm polling for big, slow buses (S-HVAC boilers): after a conversion
+    // only the sensors that left their band of +/- 'margin' °C around the
+    // last reading are read, found with a conditional search (0xEC). Every
+    // 'sweepEvery' conversions all sensors are read and all bands re-armed,
+    // which also catches a sensor that dropped off the bus. A sensor whose
+    // last read failed is read every cycle until it answers again.
+    // Sensors that are not read keep their last reading (and valid flag):
+    // check fresh(i) before taking or counting a reading.
+    // margin 0 switches alarm polling off.
+    void setAlarmPolling(uint8_t margin, uint8_t sweepEvery);
+
+    // Time poll() waits after startConversion(): the slowest sensor on the bus.
+    uint16_t conversionTime(void) const { return _conversionMs; }
+
+    // Conversion time of a DS18B20 at the given resolution (ms).
+    static uint16_t conversionTime(uint8_t bits);
+
+    // Result of the last poll() for sensor i: CRC ok? A sensor that just
+    // came back and reads its 85 °C power-up value (it missed the Convert T)
+    // is not valid for one cycle.
+    bool valid(uint8_t i) const;
+
+    // Sensor i was read by the last poll(). Always true without alarm
+    // polling; in an alarm cycle only for the sensors that were read.
+    bool fresh(uint8_t i) const;
+
+    // Raw temperature register of sensor i (LSB = 1/16 °C for DS18B20).
+    int16_t raw(uint8_t i) const;
+
+    // Temperature of sensor i in °C. Uses the family code of the ROM to
+    // pick the DS18B20 (0x28) or DS18S20 (0x10) scale.
+    double celsius(uint8_t i) const;
+
+    // Same in centi-degrees (2150 = 21.50 °C), without floating point.
+    centi_t centi(uint8_t i) const;
+
+#if ONEWIRE_STATS
+    // Bus health counters of the T-BUS as one JSON (OneWire::statsJSON()),
+    // one bus or all buses of a OneWireMulti: the sketch needs no change
+    // when it moves to several buses.
+    int statsJSON(char *buf, size_t len) const;
+#endif
+
+  private:
+    OneWire &_ds;
+    OneWireMulti *_multi;
+    const uint8_t *_busOf;
+    uint8_t (*_roms)[8];
+    uint8_t _count;
+    uint16_t _seedCrc;    // CRC16 of the compiled addrs0 table
+    int _eepromAddress;
+    uint32_t _rebound;    // bit per slot: ROM changed by the last bind()/scan()
+    uint32_t _missing;    // bit per slot: no sensor answered
+    uint32_t _fresh;      // bit per slot: read by the last poll()
+    uint32_t _powerUp;    // bit per slot: 85 °C power-up value dropped by the last poll()
+    bool _converting;
+    uint32_t _conversionStart;
+    uint16_t _conversionMs;
+    uint32_t _periodMs;       // pipelined mode: cycle period, 0 = manual
+    uint32_t _cycleStart;
+    bool _cycling;            // pipelined mode: _cycleStart is set
+    uint8_t _bits[TBUS_MAX_SENSORS];
+    uint8_t _alarmMargin;
+    uint8_t _sweepEvery;
+    uint8_t _sweepCount;
+    int16_t _raw[TBUS_MAX_SENSORS];
+    bool _valid[TBUS_MAX_SENSORS];
+
+    // Read the 9 byte scratchpad of sensor i and check its CRC.
+    bool readScratchpad(uint8_t i, uint8_t *data);
+
+    // Write TH, TL and (DS18B20 only) the config register of sensor i.
+    void writeScratchpad(uint8_t i, uint8_t th, uint8_t tl, uint8_t config);
+
+    // The bus of sensor i
+    OneWire &wire(uint8_t i) { return _multi ? _multi->bus(_busOf[i]) : _ds; }
+
+    // Read sensor i into _raw/_valid. Returns the valid flag.
+    bool readSensor(uint8_t i);
+
+    // Read all sensors in 'slots' (bit per slot) into _raw/_valid: one
+    // sensor per bus at a time, in lockstep. Returns the slots read OK.
+    uint32_t readSensors(uint32_t slots);
+
+    // Scratchpad to _raw[i]
+    void decode(uint8_t i, const uint8_t *data);
+
+    // Set the alarm band of sensor i around its last reading.
+    void armAlarm(uint8_t i);
+
+    // Index of a ROM in the table, or -1.
+    int slotOf(const uint8_t *rom) const;
+
+    void updateConversionTime(void);
+
+    // Search the bus and give unknown sensors the slots in _missing.
+    void rebind(void);
+
+    bool loadRoms(void);
+    void saveRoms(void);
+};
+
+#endif // TBus_h
@@ -62,27 +62,152 @@
 // fast pin access
 #define pinSet(_pin, _hilo) (_hilo ? pinHI(_pin) : pinLO(_pin))
 
+// Gamma 2.6: the eye sees level 128 as about 20% of 255, so a straight
+// 0..255 ramp rushes through the dark part and crawls at the top.
+// gamma8[v] = 255 * (v / 255)^2.6, rounded.
+static const uint8_t gamma8[256] = {
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0,   0,   0,   0,   0,   1,   1,   1,   1,   1,   1,   1,   1,
+    1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,   2,   3,   3,   3,   3,
+    3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   5,   6,   6,   6,   6,   7,
+    7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  10,  11,  11,  11,  12,  12,
+   13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,  20,
+   20,  21,  21,  22,  22,  23,  24,  24,  25,  25,  26,  27,  27,  28,  29,  29,
+   30,  31,  31,  32,  33,  34,  34,  35,  36,  37,  38,  38,  39,  40,  41,  42,
+   42,  43,  44,  45,  46,  47,  48,  49,  50,  51,  52,  53,  54,  55,  56,  57,
+   58,  59,  60,  61,  62,  63,  64,  65,  66,  68,  69,  70,  71,  72,  73,  75,
+   76,  77,  78,  80,  81,  82,  84,  85,  86,  88,  89,  90,  92,  93,  94,  96,
+   97,  99, 100, 102, 103, 105, 106, 108, 109, 111, 112, 114, 115, 117, 119, 120,
+  122, 124, 125, 127, 129, 130, 132, 134, 136, 137, 139, 141, 143, 145, 146, 148,
+  150, 152, 154, 156, 158, 160, 162, 164, 166, 168, 170, 172, 174, 176, 178, 180,
+  182, 184, 186, 188, 191, 193, 195, 197, 199, 202, 204, 206, 209, 211, 213, 215,
+  218, 220, 223, 225, 227, 230, 232, 235, 237, 240, 242, 245, 247, 250, 252, 255
+};
+
+// Output table of the dithered frames: their bytes are final already.
+#define LINEAR16(n) n, n+1, n+2, n+3, n+4, n+5, n+6, n+7, n+8, n+9, n+10, n+11, n+12, n+13, n+14, n+15
+static const uint8_t linear8[256] = {
+  LINEAR16(0),   LINEAR16(16),  LINEAR16(32),  LINEAR16(48),
+  LINEAR16(64),  LINEAR16(80),  LINEAR16(96),  LINEAR16(112),
+  LINEAR16(128), LINEAR16(144), LINEAR16(160), LINEAR16(176),
+  LINEAR16(192), LINEAR16(208), LINEAR16(224), LINEAR16(240)
+};
+
+volatile bool Adafruit_NeoPixel::spiBusy = false;
+
+void Adafruit_NeoPixel::spiDone(void) {
+  spiBusy = false;
+}
+
 Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, uint8_t p, uint8_t t) :
-  numLEDs(n), numBytes(n*3), type(t), pin(p), brightness(0), pixels(NULL), endTime(0)
+  numLEDs(n), numBytes(n*3), type(t), pin(p), brightness(0), gamma(false), pixels(NULL), endTime(0),
+  dirtyFirst(0), dirtyLast(n-1), usedPixels(0), deferred(false), showPending(false), // first show() clears the strip
+  spiBuffer(NULL), spiBytes(0), spiStatic(NULL), ownPixels(true), target16(NULL), residual(NULL)
 {
   if((pixels = (uint8_t *)malloc(numBytes))) {
     memset(pixels, 0, numBytes);
   }
+  updateLevels();
+}
+
+Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, uint8_t p, uint8_t t, uint8_t *buffer, uint8_t *spi, uint16_t spiSize) :
+  numLEDs(n), numBytes(n*3), type(t), pin(p), brightness(0), gamma(false), pixels(buffer), endTime(0),
+  dirtyFirst(0), dirtyLast(n-1), usedPixels(0), deferred(false), showPending(false),
+  spiBuffer(NULL), spiBytes(0), spiStatic(spiSize >= n * 12 + NEOPIXEL_SPI_LATCH ? spi : NULL),
+  ownPixels(false), target16(NULL), residual(NULL)
+{
+  memset(pixels, 0, numBytes);
+  updateLevels();
 }
 
 Adafruit_NeoPixel::~Adafruit_NeoPixel() {
-  if(pixels) free(pixels);
+  if(pixels && ownPixels) free(pixels);
+  if(target16) free(target16);
+  if(residual) free(residual);
+  if(spiBuffer) {
+    while(spiBusy);
+    if(spiBuffer != spiStatic) free(spiBuffer);
+    SPI.end();
+  }
   pinMode(pin, INPUT);
 }
 
 void Adafruit_NeoPixel::begin(void) {
+#if (PLATFORM_ID == 6) || (PLATFORM_ID == 8) || (PLATFORM_ID == 10) // Photon (6) or P1 (8) or Electron (10)
+  if(pin == NEOPIXEL_SPI_PIN && (type == WS2812B || type == WS2812B2) && !spiBuffer) {
+    spiBytes = numBytes * 4 + NEOPIXEL_SPI_LATCH;
+    if((spiBuffer = spiStatic ? spiStatic : (uint8_t *)malloc(spiBytes))) {
+      memset(spiBuffer, 0, spiBytes); // the latch bytes stay 0
+      SPI.begin();
+      SPI.setBitOrder(MSBFIRST);
+      SPI.setDataMode(SPI_MODE0);
+      SPI.setClockDivider(SPI_CLOCK_DIV16); // 60MHz / 16 = 3.75MHz: 1.07us per WS2812 bit
+      pinMode(A3, INPUT); // SCK and MISO are not needed: give the pins back
+      pinMode(A4, INPUT);
+      return;
+    }
+  }
+#endif
   pinMode(pin, OUTPUT);
   digitalWrite(pin, LOW);
 }
 
+// Send the pixels, but only if they changed since the last frame: a show()
+// after every setPixelColor(), or twice in a row, costs nothing. In
+// deferred mode show() only notes the request and flush() sends it.
 void Adafruit_NeoPixel::show(void) {
+  if(target16) return; // dithering: refresh() sends the frames
+  if(deferred) {
+    showPending = true;
+    return;
+  }
+  if(!isDirty()) return;
+  output();
+}
+
+// Deferred mode: show() sends nothing, flush() (once per loop()) sends one
+// frame with all changes since the last one. Off: show() sends at once.
+void Adafruit_NeoPixel::setDeferred(bool on) {
+  deferred = on;
+  if(!on) flush();
+}
+
+void Adafruit_NeoPixel::flush(void) {
+  if(showPending && isDirty() && !target16) output();
+  showPending = false;
+}
+
+bool Adafruit_NeoPixel::isDirty(void) const {
+  return dirtyFirst <= dirtyLast;
+}
+
+// Add pixels first..last to the changed range (clean = 0xFFFF..0)
+void Adafruit_NeoPixel::markDirty(uint16_t first, uint16_t last) const {
+  if(first < dirtyFirst) dirtyFirst = first;
+  if(last > dirtyLast) dirtyLast = last;
+}
+
+void Adafruit_NeoPixel::output(void) {
   if(!pixels) return;
 
+  // Short frame: up to the last changed pixel. The pixels after it did not
+  // change and keep what they got from an earlier frame.
+  uint16_t sendBytes = (dirtyLast < numLEDs) ? (dirtyLast + 1) * 3 : numBytes;
+  dirtyFirst = 0xFFFF; // the frame has all changes
+  dirtyLast = 0;
+
+  if(spiBuffer) {
+    // SPI output: wait for the DMA of the previous frame (it reads
+    // spiBuffer), encode and start the next one. The trailing latch bytes
+    // keep the line low long enough, so no endTime wait.
+    while(spiBusy);
+    uint8_t *out = neoPixelEncodeSPI(pixels, sendBytes, target16 ? NULL : level, spiBuffer);
+    memset(out, 0, NEOPIXEL_SPI_LATCH); // latch right after the short frame
+    spiBusy = true;
+    SPI.transfer(spiBuffer, NULL, sendBytes * 4 + NEOPIXEL_SPI_LATCH, spiDone);
+    return;
+  }
+
   // Data latch = 24 or 50 microsecond pause in the output stream.  Rather than
   // put a delay at the end of the function, the ending time is noted and
   // the function will simply hold off (if needed) on issuing the
@@ -114,7 +239,8 @@ void Adafruit_NeoPixel::show(void) {
   volatile uint32_t
     c,    // 24-bit pixel color
     mask; // 8-bit mask
-  volatile uint16_t i = numBytes; // Output loop counter
+  const uint8_t *lut = target16 ? linear8 : level; // brightness + gamma, applied per byte
+  volatile uint16_t i = sendBytes; // Output loop counter
   volatile uint8_t
     j,              // 8-bit inner loop counter
    *ptr = pixels,   // Pointer to next byte
@@ -126,9 +252,9 @@ void Adafruit_NeoPixel::show(void) {
     while(i) { // While bytes left... (3 bytes = 1 pixel)
       mask = 0x800000; // reset the mask
       i = i-3;      // decrement bytes remaining
-      g = *ptr++;   // Next green byte value
-      r = *ptr++;   // Next red byte value
-      b = *ptr++;   // Next blue byte value
+      g = lut[*ptr++];   // Next green byte value
+      r = lut[*ptr++];   // Next red byte value
+      b = lut[*ptr++];   // Next blue byte value
       c = ((uint32_t)g << 16) | ((uint32_t)r <<  8) | b; // Pack the next 3 bytes to keep timing tight
       j = 0;        // reset the 24-bit counter
       do {
@@ -233,9 +359,9 @@ void Adafruit_NeoPixel::show(void) {
     while(i) { // While bytes left... (3 bytes = 1 pixel)
       mask = 0x800000; // reset the mask
       i = i-3;      // decrement bytes remaining
-      g = *ptr++;   // Next green byte value
-      r = *ptr++;   // Next red byte value
-      b = *ptr++;   // Next blue byte value
+      g = lut[*ptr++];   // Next green byte value
+      r = lut[*ptr++];   // Next red byte value
+      b = lut[*ptr++];   // Next blue byte value
       c = ((uint32_t)g << 16) | ((uint32_t)r <<  8) | b; // Pack the next 3 bytes to keep timing tight
       j = 0;        // reset the 24-bit counter
       do {
@@ -262,9 +388,9 @@ void Adafruit_NeoPixel::show(void) {
     while(i) { // While bytes left... (3 bytes = 1 pixel)
       mask = 0x800000; // reset the mask
       i = i-3;      // decrement bytes remaining
-      r = *ptr++;   // Next red byte value
-      g = *ptr++;   // Next green byte value
-      b = *ptr++;   // Next blue byte value
+      r = lut[*ptr++];   // Next red byte value
+      g = lut[*ptr++];   // Next green byte value
+      b = lut[*ptr++];   // Next blue byte value
       c = ((uint32_t)r << 16) | ((uint32_t)g <<  8) | b; // Pack the next 3 bytes to keep timing tight
       j = 0;        // reset the 24-bit counter
       do {
@@ -420,9 +546,9 @@ void Adafruit_NeoPixel::show(void) {
     while(i) { // While bytes left... (3 bytes = 1 pixel)
       mask = 0x800000; // reset the mask
       i = i-3;      // decrement bytes remaining
-      r = *ptr++;   // Next red byte value
-      g = *ptr++;   // Next blue byte value
-      b = *ptr++;   // Next green byte value
+      r = lut[*ptr++];   // Next red byte value
+      g = lut[*ptr++];   // Next blue byte value
+      b = lut[*ptr++];   // Next green byte value
       c = ((uint32_t)r << 16) | ((uint32_t)g <<  8) | b; // Pack the next 3 bytes to keep timing tight
       j = 0;        // reset the 24-bit counter
       do {
@@ -557,9 +683,9 @@ void Adafruit_NeoPixel::show(void) {
     while(i) { // While bytes left... (3 bytes = 1 pixel)
       mask = 0x800000; // reset the mask
       i = i-3;      // decrement bytes remaining
-      r = *ptr++;   // Next red byte value
-      b = *ptr++;   // Next blue byte value
-      g = *ptr++;   // Next green byte value
+      r = lut[*ptr++];   // Next red byte value
+      b = lut[*ptr++];   // Next blue byte value
+      g = lut[*ptr++];   // Next green byte value
       c = ((uint32_t)r << 16) | ((uint32_t)b <<  8) | g; // Pack the next 3 bytes to keep timing tight
       j = 0;        // reset the 24-bit counter
       pinSet(pin, LOW); // LOW
@@ -654,6 +780,12 @@ void Adafruit_NeoPixel::show(void) {
 
 // Set the output pin number
 void Adafruit_NeoPixel::setPin(uint8_t p) {
+  if(spiBuffer) { // back to bit-banging (begin() again for SPI on A5)
+    while(spiBusy);
+    if(spiBuffer != spiStatic) free(spiBuffer);
+    spiBuffer = NULL;
+    SPI.end();
+  }
   pinMode(pin, INPUT);
   pin = p;
   pinMode(p, OUTPUT);
@@ -663,72 +795,119 @@ void Adafruit_NeoPixel::setPin(uint8_t p) {
 // Set pixel color from separate R,G,B components:
 void Adafruit_NeoPixel::setPixelColor(
  uint16_t n, uint8_t r, uint8_t g, uint8_t b) {
+  if(target16) {
+    setPixelColor16(n, r * 257, g * 257, b * 257); // 255 -> 65535
+    return;
+  }
   if(n < numLEDs) {
-    if(brightness) { // See notes in setBrightness()
-      r = (r * brightness) >> 8;
-      g = (g * brightness) >> 8;
-      b = (b * brightness) >> 8;
-    }
     uint8_t *p = &pixels[n * 3];
-    switch(type) {
-      case WS2812B: // WS2812 & WS2812B is GRB order.
-      case WS2812B2:
-        *p++ = g;
-        *p++ = r;
-        *p = b;
-        break;
-      case TM1829: // TM1829 is special RBG order
-        if(r == 255) r = 254; // 255 on RED channel causes display to be in a special mode.
-        *p++ = r;
-        *p++ = b;
-        *p = g;
-        break;
-      case WS2811: // WS2811 is RGB order
-      case TM1803: // TM1803 is RGB order
-      default:     // default is RGB order
-        *p++ = r;
-        *p++ = g;
-        *p = b;
-        break;
-    }
+    uint8_t p0 = p[0], p1 = p[1], p2 = p[2];
+    if(n >= usedPixels) usedPixels = n + 1;
+    neoPixelPack(type, p, r, g, b); // byte order of 'type' (NeoPixelEncode.h)
+    if(p[0] != p0 || p[1] != p1 || p[2] != p2) markDirty(n, n);
   }
 }
 
 // Set pixel color from 'packed' 32-bit RGB color:
 void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint32_t c) {
+  setPixelColor(n, (uint8_t)(c >> 16), (uint8_t)(c >> 8), (uint8_t)c);
+}
+
+// Set pixel color with 16 bits per channel (0..65535). Only dithering
+// sends the low byte: without it this is setPixelColor(r >> 8, ...).
+void Adafruit_NeoPixel::setPixelColor16(uint16_t n, uint16_t r, uint16_t g, uint16_t b) {
+  if(!target16) {
+    setPixelColor(n, r >> 8, g >> 8, b >> 8);
+    return;
+  }
   if(n < numLEDs) {
-    uint8_t
-      r = (uint8_t)(c >> 16),
-      g = (uint8_t)(c >>  8),
-      b = (uint8_t)c;
-    if(brightness) { // See notes in setBrightness()
-      r = (r * brightness) >> 8;
-      g = (g * brightness) >> 8;
-      b = (b * brightness) >> 8;
-    }
-    uint8_t *p = &pixels[n * 3];
-    switch(type) {
-      case WS2812B: // WS2812 & WS2812B is GRB order.
-      case WS2812B2:
-        *p++ = g;
-        *p++ = r;
-        *p = b;
-        break;
-      case TM1829: // TM1829 is special RBG order
-        if(r == 255) r = 254; // 255 on RED channel causes display to be in a special mode.
-        *p++ = r;
-        *p++ = b;
-        *p = g;
-        break;
-      case WS2811: // WS2811 is RGB order
-      case TM1803: // TM1803 is RGB order
-      default:     // default is RGB order
-        *p++ = r;
-        *p++ = g;
-        *p = b;
-        break;
+    NeoPixelOrder o = neoPixelOrder(type);
+    uint16_t *t = &target16[n * 3];
+    if(type == TM1829 && r > 0xFEFF) r = 0xFEFF; // see neoPixelPack()
+    if(n >= usedPixels) usedPixels = n + 1;
+    t[o.r] = r;
+    t[o.g] = g;
+    t[o.b] = b;
+  }
+}
+
+void Adafruit_NeoPixel::getPixelColor16(uint16_t n, uint16_t *r, uint16_t *g, uint16_t *b) const {
+  if(n >= numLEDs) {
+    *r = *g = *b = 0;
+    return;
+  }
+  if(!target16) {
+    uint32_t c = getPixelColor(n);
+    *r = ((c >> 16) & 0xFF) * 257;
+    *g = ((c >> 8) & 0xFF) * 257;
+    *b = (c & 0xFF) * 257;
+    return;
+  }
+  NeoPixelOrder o = neoPixelOrder(type);
+  const uint16_t *t = &target16[n * 3];
+  *r = t[o.r];
+  *g = t[o.g];
+  *b = t[o.b];
+}
+
+// Temporal dithering: every channel has a 16 bit target. Each refresh()
+// sends the 8 bit level just below or above it, so that the average over
+// the frames is the 16 bit value (error diffusion: the rest of a frame is
+// carried to the next one). The level is the 'level' table interpolated,
+// so brightness and gamma keep working, and the steps at the low end
+// (1 -> 2 = double the light) become 256 small ones.
+// Costs 3 bytes per pixel (targets + rests); false if there is no room.
+bool Adafruit_NeoPixel::setDither(bool on) {
+  if(on == (target16 != NULL)) return true;
+  if(!on) {
+    uint16_t *t = target16;
+    target16 = NULL; // setPixelColor() writes 'pixels' again
+    for(uint16_t k = 0; k < numBytes; k++) pixels[k] = t[k] >> 8;
+    free(t);
+    free(residual);
+    residual = NULL;
+    if(usedPixels) markDirty(0, usedPixels - 1);
+    return true;
+  }
+  if(!pixels) return false;
+  uint16_t *t = (uint16_t *)malloc(numBytes * 2);
+  if(!t) return false;
+  if(!(residual = (uint8_t *)malloc(numBytes))) {
+    free(t);
+    return false;
+  }
+  memset(residual, 0, numBytes);
+  for(uint16_t k = 0; k < numBytes; k++) t[k] = pixels[k] * 257;
+  target16 = t;
+  return true;
+}
+
+bool Adafruit_NeoPixel::isDithering(void) const {
+  return target16 != NULL;
+}
+
+// Next dithered frame, once per loop() pass: not from a Timer, which would
+// race with setPixelColor...() over the targets and rests (and read them
+// after setDither(false) freed them). Sends only the pixels up to the last
+// one whose byte changed, and nothing at all while every channel sits
+// exactly on a level.
+void Adafruit_NeoPixel::refresh(void) {
+  if(!target16) return;
+  uint16_t count = usedPixels * 3;
+  for(uint16_t k = 0; k < count; k++) {
+    uint16_t t = target16[k];
+    uint8_t hi = t >> 8, lo = t;
+    uint16_t out = (uint16_t)level[hi] << 8; // 8.8 output level
+    if(hi < 255) out += (level[hi + 1] - level[hi]) * lo;
+    uint16_t sum = residual[k] + (out & 0xFF);
+    uint8_t v = (out >> 8) + (sum >> 8);
+    residual[k] = sum;
+    if(v != pixels[k]) {
+      pixels[k] = v;
+      markDirty(k / 3, k / 3);
     }
   }
+  if(isDirty()) output();
 }
 
 void Adafruit_NeoPixel::setColor(uint16_t aLedNumber, byte aRed, byte aGreen, byte aBlue) {
@@ -740,9 +919,9 @@ void Adafruit_NeoPixel::setColorScaled(uint16_t aLedNumber, byte aRed, byte aGre
   setColor(aLedNumber, (aRed*aScaling)>>8, (aGreen*aScaling)>>8, (aBlue*aScaling)>>8);
 }
 
+// Perceived brightness (0..255) to PWM level: the gamma table, all 256 steps.
 byte Adafruit_NeoPixel::brightnessToPWM(byte aBrightness) {
-  static const byte pwmLevels[16] = { 0, 1, 2, 3, 4, 6, 8, 12, 23, 36, 48, 70, 95, 135, 190, 255 };
-  return pwmLevels[aBrightness>>4];
+  return gamma8[aBrightness];
 }
 
 void Adafruit_NeoPixel::setColorDimmed(uint16_t aLedNumber, byte aRed, byte aGreen, byte aBlue, byte aBrightness) {
@@ -761,37 +940,20 @@ uint32_t Adafruit_NeoPixel::getPixelColor(uint16_t n) const {
     // Out of bounds, return no color.
     return 0;
   }
-  uint8_t *p = &pixels[n * 3];
-  uint32_t c;
-
-  switch(type) {
-    case WS2812B: // WS2812 & WS2812B is GRB order.
-    case WS2812B2:
-      c = ((uint32_t)p[1] << 16) | ((uint32_t)p[0] <<  8) | (uint32_t)p[2];
-      break;
-    case TM1829: // TM1829 is special RBG order
-      c = ((uint32_t)p[0] << 16) | ((uint32_t)p[2] <<  8) | (uint32_t)p[1];
-      break;
-    case WS2811: // WS2811 is RGB order
-    case TM1803: // TM1803 is RGB order
-    default:     // default is RGB order
-      c = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] <<  8) | (uint32_t)p[2];
-      break;
+  if(target16) {
+    uint16_t r, g, b;
+    getPixelColor16(n, &r, &g, &b);
+    return Color(r >> 8, g >> 8, b >> 8);
   }
+  uint32_t c = neoPixelUnpack(type, &pixels[n * 3]);
 
-  // Adjust this back up to the true color, as setting a pixel color will
-  // scale it back down again.
-  if(brightness) { // See notes in setBrightness()
-    //Cast the color to a byte array
-    uint8_t * c_ptr =reinterpret_cast<uint8_t*>(&c);
-    c_ptr[0] = (c_ptr[0] << 8)/brightness;
-    c_ptr[1] = (c_ptr[1] << 8)/brightness;
-    c_ptr[2] = (c_ptr[2] << 8)/brightness;
-  }
-  return c; // Pixel # is out of bounds
+  return c; // The buffer is not scaled: exactly the color that was set
 }
 
+// Direct access to the buffer: the next show() sends all pixels
 uint8_t *Adafruit_NeoPixel::getPixels(void) const {
+  if(numLEDs) markDirty(0, numLEDs - 1);
+  usedPixels = numLEDs;
   return pixels;
 }
 
@@ -805,16 +967,11 @@ uint16_t Adafruit_NeoPixel::getNumLeds(void) const {
 
 // Adjust output brightness; 0=darkest (off), 255=brightest.  This does
 // NOT immediately affect what's currently displayed on the LEDs.  The
-// next call to show() will refresh the LEDs at this level.  However,
-// this process is potentially "lossy," especially when increasing
-// brightness.  The tight timing in the WS2811/WS2812 code means there
-// aren't enough free cycles to perform this scaling on the fly as data
-// is issued.  So we make a pass through the existing color data in RAM
-// and scale it (subsequent graphics commands also work at this
-// brightness level).  If there's a significant step up in brightness,
-// the limited number of steps (quantization) in the old data will be
-// quite visible in the re-scaled version.  For a non-destructive
-// change, you'll need to re-render the full strip data.  C'est la vie.
+// next call to show() will refresh the LEDs at this level.  The pixel
+// buffer keeps the colors as they were set: brightness (and gamma) are
+// applied while a frame is sent, through the 256 byte 'level' table.  So
+// a change is lossless (dim to 10 and back to 255: the same colors) and
+// only costs rebuilding the table.
 void Adafruit_NeoPixel::setBrightness(uint8_t b) {
   // Stored brightness value is different than what's passed.
   // This simplifies the actual scaling math later, allowing a fast
@@ -824,27 +981,43 @@ void Adafruit_NeoPixel::setBrightness(uint8_t b) {
   // brightness (off), 255 = just below max brightness.
   uint8_t newBrightness = b + 1;
   if(newBrightness != brightness) { // Compare against prior value
-    // Brightness has changed -- re-scale existing data in RAM
-    uint8_t  c,
-            *ptr           = pixels,
-             oldBrightness = brightness - 1; // De-wrap old brightness value
-    uint16_t scale;
-    if(oldBrightness == 0) scale = 0; // Avoid /0
-    else if(b == 255) scale = 65535 / oldBrightness;
-    else scale = (((uint16_t)newBrightness << 8) - 1) / oldBrightness;
-    for(uint16_t i=0; i<numBytes; i++) {
-      c      = *ptr;
-      *ptr++ = (c * scale) >> 8;
-    }
     brightness = newBrightness;
+    updateLevels();
   }
 }
 
+// Gamma correction of the output: perceptually even steps (fades, low
+// night light levels). Off: the color values are sent as they are.
+void Adafruit_NeoPixel::setGamma(bool on) {
+  if(on != gamma) {
+    gamma = on;
+    updateLevels();
+  }
+}
+
+// Output level of every color value: gamma first, then brightness. The
+// next frame sends all pixels that can be lit.
+void Adafruit_NeoPixel::updateLevels(void) {
+  for(uint16_t v = 0; v < 256; v++) {
+    uint8_t c = gamma ? gamma8[v] : v;
+    level[v] = brightness ? (c * brightness) >> 8 : c;
+  }
+  if(usedPixels) markDirty(0, usedPixels - 1); // the others are 0
+}
+
 //Return the brightness value
 uint8_t Adafruit_NeoPixel::getBrightness(void) const {
   return brightness - 1;
 }
 
+// Only the pixels written since the last clear() can be lit: the next frame
+// blanks those, and the short frames start over.
 void Adafruit_NeoPixel::clear(void) {
   memset(pixels, 0, numBytes);
+  if(target16) {
+    memset(target16, 0, numBytes * 2);
+    memset(residual, 0, numBytes);
+  }
+  if(usedPixels) markDirty(0, usedPixels - 1);
+  usedPixels = 0;
 }
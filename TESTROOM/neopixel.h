@@ -51,14 +51,31 @@
 #define SPARK_NEOPIXEL_H
 
 #include "application.h"
-
-// 'type' flags for LED pixels (third parameter to constructor):
-#define WS2812   0x02 // 800 KHz datastream (NeoPixel)
-#define WS2812B  0x02 // 800 KHz datastream (NeoPixel)
-#define WS2811   0x00 // 400 KHz datastream (NeoPixel)
-#define TM1803   0x03 // 400 KHz datastream (Radio Shack Tri-Color Strip)
-#define TM1829   0x04 // 800 KHz datastream ()
-#define WS2812B2 0x05 // 800 KHz datastream (NeoPixel)
+#include "NeoPixelEncode.h" // 'type' flags, byte order and SPI encoding
+
+// SPI + DMA output (Photon, P1, Electron): a WS2812/WS2812B strip with its
+// data line on the SPI MOSI pin (A5) is not bit-banged. Every WS2812 bit is
+// sent as 4 SPI bits (1 = 1110, 0 = 1000) at 3.75 MHz, by DMA: show()
+// returns at once and interrupts stay on, so the cloud connection keeps
+// running during a frame. Any other pin or type: bit-banged as before.
+// The SPI clock (A3) and MISO (A4) pins are not used and stay free.
+//
+// Short frames: show() only sends the pixels up to the last one that
+// changed (pixel 0 first, the chain keeps the others). A strip of 50 with
+// only the 4 PowerPixels in use sends 12 bytes instead of 150.
+//
+// Brightness and gamma: the pixel buffer holds the colors as set, they are
+// scaled through a 256 byte table while the frame is sent. setBrightness()
+// is lossless and cheap, setGamma(true) gives perceptually even steps.
+//
+// Dithering: setDither(true) keeps 16 bits per channel (setPixelColor16())
+// and refresh(), called once per loop() pass, alternates the two nearest
+// 8 bit levels: smooth fades at the low end. 'pixels' then holds the bytes
+// of the last frame, show() and flush() send nothing. refresh() and
+// setDither(false) share the buffers with setPixelColor...(): call them
+// from loop() only, not from a Timer or an interrupt.
+#define NEOPIXEL_SPI_PIN      A5
+#define NEOPIXEL_SPI_LATCH    32 // trailing zero bytes: 68us low = latch
 
 class Adafruit_NeoPixel {
 
@@ -70,15 +87,25 @@ class Adafruit_NeoPixel {
 
   void
     begin(void),
-    show(void) __attribute__((optimize("Ofast"))),
+    show(void),
     setPin(uint8_t p),
     setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b),
     setPixelColor(uint16_t n, uint32_t c),
     setBrightness(uint8_t),
+    setGamma(bool on),
     setColor(uint16_t aLedNumber, byte aRed, byte aGreen, byte aBlue),
     setColorScaled(uint16_t aLedNumber, byte aRed, byte aGreen, byte aBlue, byte aScaling),
     setColorDimmed(uint16_t aLedNumber, byte aRed, byte aGreen, byte aBlue, byte aBrightness),
-    clear(void);
+    clear(void),
+    setDeferred(bool on),
+    flush(void),
+    setPixelColor16(uint16_t n, uint16_t r, uint16_t g, uint16_t b),
+    getPixelColor16(uint16_t n, uint16_t *r, uint16_t *g, uint16_t *b) const,
+    refresh(void);
+  bool
+    setDither(bool on),
+    isDithering(void) const,
+    isDirty(void) const;
   uint8_t
    *getPixels() const,
     getBrightness(void) const;
@@ -92,7 +119,12 @@ class Adafruit_NeoPixel {
   byte
     brightnessToPWM(byte aBrightness);
 
- private:
+ protected:
+
+  // Constructor for Adafruit_NeoPixelStatic: 'buffer' (3 * n bytes) and
+  // 'spi' (spiSize bytes, NULL = none) belong to the caller, nothing is
+  // allocated or freed.
+  Adafruit_NeoPixel(uint16_t n, uint8_t p, uint8_t t, uint8_t *buffer, uint8_t *spi, uint16_t spiSize);
 
   const uint16_t
     numLEDs,       // Number of RGB LEDs in strip
@@ -101,10 +133,105 @@ class Adafruit_NeoPixel {
     type;          // Pixel type flag (400 vs 800 KHz)
   uint8_t
     pin,           // Output pin number
-    brightness,
-   *pixels;        // Holds LED color values (3 bytes each)
+    brightness;    // 0 = full, else 1 (off)..255 (see setBrightness())
+  bool
+    gamma;         // Output through gamma8[] (setGamma())
+  uint8_t
+   *pixels,        // Holds LED color values (3 bytes each), not scaled
+    level[256];    // Output value of each color value: gamma + brightness
   uint32_t
     endTime;       // Latch timing reference
+  mutable uint16_t
+    dirtyFirst,    // Changed pixels since the last frame: dirtyFirst..dirtyLast
+    dirtyLast;     // (dirtyFirst > dirtyLast = nothing changed; getPixels() = all)
+  mutable uint16_t
+    usedPixels;    // Highest pixel written since begin()/clear() + 1
+  bool
+    deferred,      // show() only requests a frame, flush() sends it
+    showPending;   // show() was called in deferred mode
+  uint8_t
+   *spiBuffer;     // SPI output: encoded frame + latch (NULL = bit-bang)
+  uint16_t
+    spiBytes;      // Size of 'spiBuffer'
+  uint8_t
+   *spiStatic;     // SPI buffer given to the constructor (NULL = malloc() in begin())
+  bool
+    ownPixels;     // 'pixels' was malloc()ed by the constructor
+  uint16_t
+   *target16;      // Dithering: 16 bit color values (NULL = off)
+  uint8_t
+   *residual;      // Dithering: rest of each channel carried to the next frame
+
+  void
+    markDirty(uint16_t first, uint16_t last) const;
+
+ private:
+
+  static volatile bool
+    spiBusy;       // DMA transfer of a frame running
+  static void
+    spiDone(void);
+
+  void
+    updateLevels(void),
+    output(void) __attribute__((optimize("Ofast")));
+};
+
+// A strip whose length, pin and type are fixed in the sketch:
+//
+//    Adafruit_NeoPixelStatic<50, D4, WS2812B> strip;
+//
+// The pixel buffer (3 * N bytes) and, for a WS2812/WS2812B on A5, the SPI
+// buffer are arrays inside the object: a global strip is in .bss, counted
+// by the linker, and nothing is malloc()ed (setDither(true) still is). The
+// byte order is resolved at compile time, so setPixelColor() is three
+// stores instead of a switch on the type. Fader, LightScenes... take it as
+// an Adafruit_NeoPixel&: through that reference they get the generic
+// setPixelColor(), with the same result.
+template <uint16_t N, uint8_t PIN, uint8_t TYPE = WS2812B>
+class Adafruit_NeoPixelStatic : public Adafruit_NeoPixel {
+
+ public:
+
+  static const uint16_t
+    SPI_BYTES = (PIN == NEOPIXEL_SPI_PIN && (TYPE == WS2812B || TYPE == WS2812B2)) ?
+                N * 12 + NEOPIXEL_SPI_LATCH : 0;
+
+  Adafruit_NeoPixelStatic() :
+    Adafruit_NeoPixel(N, PIN, TYPE, buffer, SPI_BYTES ? spi : NULL, SPI_BYTES) {}
+
+  void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b) {
+    if(n >= N || target16) { // dithering: 16 bit values, see setPixelColor16()
+      Adafruit_NeoPixel::setPixelColor(n, r, g, b);
+      return;
+    }
+    uint8_t *p = &buffer[n * 3];
+    if(TYPE == TM1829 && r == 255) r = 254; // see neoPixelPack()
+    if(n >= usedPixels) usedPixels = n + 1;
+    if(p[NeoPixelOrderOf<TYPE>::r] == r && p[NeoPixelOrderOf<TYPE>::g] == g && p[NeoPixelOrderOf<TYPE>::b] == b) return;
+    p[NeoPixelOrderOf<TYPE>::r] = r;
+    p[NeoPixelOrderOf<TYPE>::g] = g;
+    p[NeoPixelOrderOf<TYPE>::b] = b;
+    markDirty(n, n);
+  }
+
+  void setPixelColor(uint16_t n, uint32_t c) {
+    setPixelColor(n, (uint8_t)(c >> 16), (uint8_t)(c >> 8), (uint8_t)c);
+  }
+
+  uint32_t getPixelColor(uint16_t n) const {
+    if(n >= N || target16) return Adafruit_NeoPixel::getPixelColor(n);
+    const uint8_t *p = &buffer[n * 3];
+    return ((uint32_t)p[NeoPixelOrderOf<TYPE>::r] << 16) |
+           ((uint32_t)p[NeoPixelOrderOf<TYPE>::g] <<  8) |
+                      p[NeoPixelOrderOf<TYPE>::b];
+  }
+
+ private:
+
+  uint8_t
+    buffer[N * 3],                   // the 'pixels' of the base class
+    spi[SPI_BYTES ? SPI_BYTES : 1];  // its 'spiBuffer' (SPI output only)
 };
 
 #endif // ADAFRUIT_NEOPIXEL_H